@@ -0,0 +1,237 @@
+// PocketbaseAuth.cpp
+
+#include "PocketbaseExtended.h"
+#include "PocketbaseTime.h"
+
+#if PB_ENABLE_AUTH
+
+// Delay before retrying a refresh that failed for a transport reason (the token itself may still be valid)
+#define PB_AUTH_RETRY_MS 10000
+// Longest delay that can be scheduled against millis() without wrapping, about 20 days
+#define PB_AUTH_MAX_REFRESH_DELAY_MS 1728000000UL
+
+// Returns the string value of a top level "key": "value" pair. Good enough for the auth responses,
+// whose token never contains escaped characters.
+static String jsonStringValue(const String &json, const char *key)
+{
+    String pattern = "\"";
+    pattern += key;
+    pattern += "\"";
+
+    int keyAt = json.indexOf(pattern);
+    if (keyAt == -1)
+    {
+        return "";
+    }
+
+    int start = json.indexOf('"', json.indexOf(':', keyAt + pattern.length()) + 1);
+    int end = start == -1 ? -1 : json.indexOf('"', start + 1);
+    if (end == -1)
+    {
+        return "";
+    }
+    return json.substring(start + 1, end);
+}
+
+static int8_t base64UrlValue(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '-' || c == '+')
+        return 62;
+    if (c == '_' || c == '/')
+        return 63;
+    return -1;
+}
+
+// Reads a numeric claim ("exp", "iat") from the payload segment of a JWT, without allocating
+static bool jwtNumericClaim(const String &token, const char *claim, uint32_t &value)
+{
+    int start = token.indexOf('.');
+    int end = start == -1 ? -1 : token.indexOf('.', start + 1);
+    if (end == -1)
+    {
+        return false;
+    }
+
+    char payload[256];
+    size_t length = 0;
+    uint32_t bits = 0;
+    uint8_t bitCount = 0;
+    for (int i = start + 1; i < end && length < sizeof(payload) - 1; i++)
+    {
+        int8_t sextet = base64UrlValue(token[i]);
+        if (sextet < 0)
+        {
+            break;
+        }
+        bits = (bits << 6) | (uint32_t)sextet;
+        bitCount += 6;
+        if (bitCount >= 8)
+        {
+            bitCount -= 8;
+            payload[length++] = (char)((bits >> bitCount) & 0xFF);
+        }
+    }
+    payload[length] = '\0';
+
+    char pattern[16];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", claim);
+    const char *found = strstr(payload, pattern);
+    if (found == nullptr)
+    {
+        return false;
+    }
+
+    value = strtoul(found + strlen(pattern), nullptr, 10);
+    return true;
+}
+
+// dateHeader is the Date of the response that carried the token, nullptr when it was given by the caller
+void PocketbaseExtended::storeAuthToken(const String &token, const char *dateHeader)
+{
+    auth_token = token;
+    auth_refresh_at = 0;
+
+    uint32_t expiresAt;
+    if (!jwtNumericClaim(auth_token, "exp", expiresAt))
+    {
+        return;
+    }
+
+    // The lifetime is exp - iat, which unlike exp alone does not need a synchronized clock. PocketBase tokens
+    // only carry exp: their lifetime is then what is left of it at the server time, taken from the server
+    // clock or else from the Date of the auth response.
+    int64_t lifetimeMs = -1;
+    uint32_t issuedAt;
+    int64_t serverNowMs;
+    if (jwtNumericClaim(auth_token, "iat", issuedAt))
+    {
+        lifetimeMs = ((int64_t)expiresAt - issuedAt) * 1000;
+    }
+#if PB_ENABLE_SERVER_CLOCK
+    else if (hasServerTime())
+    {
+        lifetimeMs = expiresAt * 1000LL - serverTimeMs();
+    }
+#endif
+    else if (pocketbaseParseHttpDate(dateHeader, serverNowMs))
+    {
+        lifetimeMs = expiresAt * 1000LL - serverNowMs;
+    }
+    if (lifetimeMs <= 0)
+    {
+        PB_LOG("[PB] Token lifetime unknown or over, it will not be refreshed\n");
+        return;
+    }
+
+    uint64_t refreshDelay = (uint64_t)lifetimeMs * (100 - PB_AUTH_REFRESH_PERCENT) / 100;
+    if (refreshDelay > PB_AUTH_MAX_REFRESH_DELAY_MS)
+    {
+        refreshDelay = PB_AUTH_MAX_REFRESH_DELAY_MS;
+    }
+    auth_refresh_at = millis() + (uint32_t)refreshDelay;
+    // 0 means "never", avoid it on the rare exact hit
+    if (auth_refresh_at == 0)
+    {
+        auth_refresh_at = 1;
+    }
+}
+
+PocketbaseResponse PocketbaseExtended::authWithPassword(const char *authCollection, const char *identity, const char *password)
+{
+    clearAuth();
+    auth_collection = authCollection;
+
+    String path = "collections/";
+    path += authCollection;
+    path += "/auth-with-password";
+
+    String requestBody;
+    PocketbaseJsonWriter json(requestBody);
+    json.beginObject().field("identity", identity).field("password", password).endObject();
+
+    // The response holds the token
+    response_secret = true;
+    String payload = dispatchRequest("POST", path, &requestBody);
+    response_secret = false;
+    if (last_status == 200)
+    {
+        storeAuthToken(jsonStringValue(payload, "token"), response_headers.date);
+    }
+    return PocketbaseResponse(last_status, std::move(payload));
+}
+
+void PocketbaseExtended::setAuthToken(const char *authCollection, const char *token)
+{
+    auth_collection = authCollection;
+    storeAuthToken(token, nullptr);
+}
+
+void PocketbaseExtended::clearAuth()
+{
+    auth_token = "";
+    auth_refresh_at = 0;
+}
+
+const String &PocketbaseExtended::authToken() const
+{
+    return auth_token;
+}
+
+bool PocketbaseExtended::refreshAuthIfNeeded()
+{
+    if (auth_refreshing || auth_token.length() == 0 || auth_refresh_at == 0 ||
+        (int32_t)(millis() - auth_refresh_at) < 0)
+    {
+        return true;
+    }
+    return refreshAuth();
+}
+
+bool PocketbaseExtended::refreshAuth()
+{
+    // Single flight: the refresh request itself, or a request failing while it runs, must not start another one
+    if (auth_refreshing)
+    {
+        return false;
+    }
+    auth_refreshing = true;
+
+    String path = "collections/";
+    path += auth_collection;
+    path += "/auth-refresh";
+
+    PB_LOG("[PB] Refreshing auth token...\n");
+    response_secret = true;
+    String payload = dispatchRequest("POST", path, nullptr);
+    response_secret = false;
+    auth_refreshing = false;
+
+    if (last_status == 200)
+    {
+        String token = jsonStringValue(payload, "token");
+        if (token.length() > 0)
+        {
+            storeAuthToken(token, response_headers.date);
+            return true;
+        }
+    }
+
+    if (last_status == 401 || last_status == 403)
+    {
+        // The token is no longer accepted, there is nothing left to refresh
+        clearAuth();
+    }
+    else
+    {
+        auth_refresh_at = millis() + PB_AUTH_RETRY_MS;
+    }
+    return false;
+}
+
+#endif
@@ -0,0 +1,92 @@
+// PocketbaseClock.cpp
+
+#include "PocketbaseExtended.h"
+#include "PocketbaseTime.h"
+
+#if PB_ENABLE_SERVER_CLOCK
+
+// Worst case drift assumed between the local crystal and the server clock, in parts per million
+#define PB_CLOCK_DRIFT_PPM 100
+
+// millis() extended to 64 bits so offsets survive its 49 days wrap around
+static uint64_t monotonicMs()
+{
+    static uint32_t lastMillis = 0;
+    static uint32_t wraps = 0;
+
+    uint32_t now = millis();
+    if (now < lastMillis)
+    {
+        wraps++;
+    }
+    lastMillis = now;
+    return ((uint64_t)wraps << 32) | now;
+}
+
+// Called once the headers of a response are stored, with when its request was sent and when it arrived
+void PocketbaseExtended::updateServerClock(uint32_t sentAt, uint32_t receivedAt)
+{
+    int64_t dateMs;
+    if (!pocketbaseParseHttpDate(response_headers.date, dateMs))
+    {
+        return;
+    }
+
+    uint64_t now = monotonicMs();
+    uint32_t nowMillis = (uint32_t)now;
+    int64_t sentMono = (int64_t)(now - (uint32_t)(nowMillis - sentAt));
+    int64_t receivedMono = (int64_t)(now - (uint32_t)(nowMillis - receivedAt));
+
+    // The server stamped the response somewhere between our send and receive, and the header
+    // truncates its clock to the second, so the true offset lies within these bounds
+    int64_t low = dateMs - receivedMono;
+    int64_t high = dateMs + 999 - sentMono;
+
+    if (clock_synced)
+    {
+        // Widen the previous estimate by the drift that may have accumulated since it was made
+        int64_t drift = (int64_t)((now - clock_synced_at) * PB_CLOCK_DRIFT_PPM / 1000000);
+        int64_t previousLow = clock_offset_low - drift;
+        int64_t previousHigh = clock_offset_high + drift;
+
+        // Keep the intersection, unless the server clock stepped and the ranges no longer overlap
+        if (previousLow <= high && low <= previousHigh)
+        {
+            low = low > previousLow ? low : previousLow;
+            high = high < previousHigh ? high : previousHigh;
+        }
+    }
+
+    clock_offset_low = low;
+    clock_offset_high = high;
+    clock_synced_at = now;
+    clock_synced = true;
+}
+
+bool PocketbaseExtended::hasServerTime() const
+{
+    return clock_synced;
+}
+
+int64_t PocketbaseExtended::serverTimeMs() const
+{
+    if (!clock_synced)
+    {
+        return 0;
+    }
+    return (int64_t)monotonicMs() + (clock_offset_low + clock_offset_high) / 2;
+}
+
+String PocketbaseExtended::serverTimestamp() const
+{
+    if (!clock_synced)
+    {
+        return "";
+    }
+
+    char timestamp[PB_TIMESTAMP_SIZE];
+    pocketbaseFormatTimestamp(serverTimeMs(), timestamp);
+    return String(timestamp);
+}
+
+#endif
@@ -0,0 +1,123 @@
+// PocketbaseConfig.h
+
+#ifndef PocketbaseConfig_h
+#define PocketbaseConfig_h
+
+/*
+    Compile-time feature selection for PocketbaseExtended.
+
+    Every subsystem below can be compiled out by setting its flag to 0, either by editing this
+    file or from the build flags (ex.: PlatformIO `build_flags = -DPB_ENABLE_AUTH=0`). A disabled
+    subsystem leaves no code, no static data and no member in PocketbaseExtended behind, only
+    its public methods disappear. tools/size_matrix.sh reports the flash/RAM cost of each one.
+*/
+
+// Serial logging of every request (URL, status code and response body)
+#ifndef PB_ENABLE_LOG
+#define PB_ENABLE_LOG 1
+#endif
+
+// Request counters and latency histogram: stats(), printStats(), latencyPercentile()
+#ifndef PB_ENABLE_STATS
+#define PB_ENABLE_STATS 1
+#endif
+
+// runDiagnostics() field self-benchmark
+#ifndef PB_ENABLE_DIAGNOSTICS
+#define PB_ENABLE_DIAGNOSTICS 1
+#endif
+
+// Server clock tracking from the Date header: serverTimeMs(), serverTimestamp()
+#ifndef PB_ENABLE_SERVER_CLOCK
+#define PB_ENABLE_SERVER_CLOCK 1
+#endif
+
+// authWithPassword() and automatic token refresh
+#ifndef PB_ENABLE_AUTH
+#define PB_ENABLE_AUTH 1
+#endif
+
+// Client-side rate limiting honoring 429/503 and Retry-After: setRateLimit()
+#ifndef PB_ENABLE_THROTTLE
+#define PB_ENABLE_THROTTLE 1
+#endif
+
+// getOne() abandoned at the p95 latency and sent again: setTimeoutRetry(). Needs PB_ENABLE_STATS for the p95 latency,
+// which is interpolated within a log2 bucket of the latency histogram: the delay can be off by up to that bucket's width.
+#ifndef PB_ENABLE_TIMEOUT_RETRY
+#define PB_ENABLE_TIMEOUT_RETRY 1
+#endif
+
+// aggregate() call to the pb_hooks/pbext_aggregate.pb.js route
+#ifndef PB_ENABLE_AGGREGATE
+#define PB_ENABLE_AGGREGATE 1
+#endif
+
+// reconcile() anti-entropy sync with the pb_hooks/pbext_digest.pb.js route
+#ifndef PB_ENABLE_RECONCILE
+#define PB_ENABLE_RECONCILE 1
+#endif
+
+// updateFirmware() OTA updates from a file field
+#ifndef PB_ENABLE_OTA
+#define PB_ENABLE_OTA 1
+#endif
+
+// beginGetList()/poll() non-blocking list downloads with a per-call time and byte budget
+#ifndef PB_ENABLE_POLL
+#define PB_ENABLE_POLL 1
+#endif
+
+// update() partial record updates
+#ifndef PB_ENABLE_UPDATE
+#define PB_ENABLE_UPDATE 1
+#endif
+
+// count() reading only totalItems of a one-record list
+#ifndef PB_ENABLE_COUNT
+#define PB_ENABLE_COUNT 1
+#endif
+
+// getOne(), update() and deleteRecord() overloads taking a PocketbaseRecordId. The class itself is always
+// available (reconcile() and the generated records use it) and costs nothing unless used.
+#ifndef PB_ENABLE_RECORD_ID
+#define PB_ENABLE_RECORD_ID 1
+#endif
+
+// Bodies of create()/update() written on a raw client, headers and body in one TLS record. Without it they go
+// through HTTPClient, which writes them separately.
+#ifndef PB_ENABLE_COALESCED_WRITES
+#define PB_ENABLE_COALESCED_WRITES 1
+#endif
+
+// setTlsProfile() cipher suite selection, and measureTlsHandshake()/printTlsProfiles() with PB_ENABLE_DIAGNOSTICS
+#ifndef PB_ENABLE_TLS_PROFILES
+#define PB_ENABLE_TLS_PROFILES 1
+#endif
+
+// lastHeaders(), with the ETag and Content-Encoding slots. Without it only the headers enabled features read are
+// collected: Date for the server clock and token refresh, Retry-After for the rate limiter.
+#ifndef PB_ENABLE_RESPONSE_HEADERS
+#define PB_ENABLE_RESPONSE_HEADERS 1
+#endif
+
+// Maximum number of endpoints a PocketbaseExtended instance can use, 1 for single server builds
+#ifndef PB_MAX_ENDPOINTS
+#define PB_MAX_ENDPOINTS 4
+#endif
+
+#if PB_ENABLE_TIMEOUT_RETRY && !PB_ENABLE_STATS
+#error "PB_ENABLE_TIMEOUT_RETRY needs PB_ENABLE_STATS"
+#endif
+
+// Response header slots compiled in, see PocketbaseResponseHeaders
+#define PB_KEEP_DATE_HEADER (PB_ENABLE_RESPONSE_HEADERS || PB_ENABLE_SERVER_CLOCK || PB_ENABLE_AUTH)
+#define PB_KEEP_RETRY_AFTER_HEADER (PB_ENABLE_RESPONSE_HEADERS || PB_ENABLE_THROTTLE)
+
+#if PB_ENABLE_LOG
+#define PB_LOG(...) Serial.printf(__VA_ARGS__)
+#else
+#define PB_LOG(...)
+#endif
+
+#endif
@@ -0,0 +1,247 @@
+// PocketbaseDiagnostics.cpp
+
+#include "PocketbaseExtended.h"
+
+#if PB_ENABLE_DIAGNOSTICS
+
+// How long a diagnostics step waits for the server before giving up
+#define PB_DIAGNOSTICS_TIMEOUT_MS 10000
+
+static void sampleDiagnosticsHeap(PocketbaseDiagnostics &diagnostics)
+{
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < diagnostics.minFreeHeap)
+    {
+        diagnostics.minFreeHeap = freeHeap;
+    }
+}
+
+// Opens client to host:port, returns the time it took or -1 on failure
+static int32_t timedConnect(Client &client, const String &host, uint16_t port)
+{
+    uint32_t startedAt = millis();
+    if (!client.connect(host.c_str(), port))
+    {
+        return -1;
+    }
+    return millis() - startedAt;
+}
+
+// Writes request on an already open connection and reads the whole response.
+// Durations are measured from the moment the request is written, so they exclude connection setup.
+static bool timedGet(Client &client, const String &request, int32_t &ttfbMs, int32_t &totalMs, int32_t &bytes)
+{
+    uint32_t startedAt = millis();
+    client.write((const uint8_t *)request.c_str(), request.length());
+
+    ttfbMs = -1;
+    bytes = 0;
+    uint8_t buffer[128];
+    uint32_t lastActivity = startedAt;
+    while (millis() - lastActivity < PB_DIAGNOSTICS_TIMEOUT_MS)
+    {
+        int available = client.available();
+        if (available > 0)
+        {
+            if (ttfbMs < 0)
+            {
+                ttfbMs = millis() - startedAt;
+            }
+            int read = client.read(buffer, available < (int)sizeof(buffer) ? available : sizeof(buffer));
+            if (read > 0)
+            {
+                bytes += read;
+            }
+            lastActivity = millis();
+        }
+        else if (!client.connected())
+        {
+            break;
+        }
+        else
+        {
+            delay(1);
+        }
+    }
+
+    totalMs = millis() - startedAt;
+    client.stop();
+    return ttfbMs >= 0;
+}
+
+PocketbaseDiagnostics PocketbaseExtended::runDiagnostics(const char *recordId /* = nullptr */, const char *perPage /* = "200" */)
+{
+    PocketbaseDiagnostics diagnostics;
+    diagnostics.dnsMs = -1;
+    diagnostics.tcpConnectMs = -1;
+    diagnostics.tlsFullMs = -1;
+    diagnostics.tlsResumedMs = -1;
+    diagnostics.ttfbMs = -1;
+    diagnostics.listMs = -1;
+    diagnostics.listBytes = -1;
+    diagnostics.listBytesPerSec = -1;
+    diagnostics.heapBefore = ESP.getFreeHeap();
+    diagnostics.minFreeHeap = diagnostics.heapBefore;
+
+    // Diagnostics always measure the primary endpoint
+    const PocketbaseServer &server = servers[primary_server];
+
+    IPAddress ip;
+    uint32_t startedAt = millis();
+    if (WiFi.hostByName(server.host.c_str(), ip) != 1)
+    {
+        diagnostics.heapAfter = ESP.getFreeHeap();
+        return diagnostics;
+    }
+    diagnostics.dnsMs = millis() - startedAt;
+
+    WiFiClient tcp;
+    startedAt = millis();
+    if (tcp.connect(ip, server.port))
+    {
+        diagnostics.tcpConnectMs = millis() - startedAt;
+    }
+    tcp.stop();
+    sampleDiagnosticsHeap(diagnostics);
+
+    // Connections used for the HTTP exchanges. With TLS, the first handshake is a full one and the
+    // following ones resume its session, which is what a client reusing sessions would pay.
+    std::unique_ptr<PocketbaseSecureClient> secureClient;
+    WiFiClient plainClient;
+    Client *client = &plainClient;
+#if defined(ESP8266)
+    BearSSL::Session session;
+#endif
+
+    if (server.secure)
+    {
+        secureClient.reset(new PocketbaseSecureClient);
+        configureSecureClient(*secureClient);
+#if defined(ESP8266)
+        secureClient->setSession(&session);
+#endif
+        client = secureClient.get();
+
+        diagnostics.tlsFullMs = timedConnect(*client, server.host, server.port);
+        sampleDiagnosticsHeap(diagnostics);
+        client->stop();
+#if defined(ESP8266)
+        diagnostics.tlsResumedMs = timedConnect(*client, server.host, server.port);
+        sampleDiagnosticsHeap(diagnostics);
+        client->stop();
+#endif
+    }
+
+    int32_t totalMs;
+    int32_t bytes;
+
+    if (recordId != nullptr && current_endpoint.length() > 0 &&
+        timedConnect(*client, server.host, server.port) >= 0)
+    {
+        // Same head as the requests of the library, with the auth token: collections whose rules need one
+        // would otherwise answer an error page and measure nothing
+        String request;
+        writeRequestHead(request, server, "GET", recordsPath(recordId, 0), nullptr);
+        timedGet(*client, request, diagnostics.ttfbMs, totalMs, bytes);
+        sampleDiagnosticsHeap(diagnostics);
+    }
+
+    if (perPage != nullptr && current_endpoint.length() > 0 &&
+        timedConnect(*client, server.host, server.port) >= 0)
+    {
+        String path = recordsPath(nullptr, 0);
+        path += "?skipTotal=1&perPage=";
+        path += perPage;
+        String request;
+        writeRequestHead(request, server, "GET", path, nullptr);
+
+        int32_t ttfbMs;
+        if (timedGet(*client, request, ttfbMs, totalMs, bytes))
+        {
+            diagnostics.listMs = totalMs;
+            diagnostics.listBytes = bytes;
+            diagnostics.listBytesPerSec = totalMs > 0 ? (int32_t)((int64_t)bytes * 1000 / totalMs) : bytes;
+        }
+        sampleDiagnosticsHeap(diagnostics);
+    }
+
+    diagnostics.heapAfter = ESP.getFreeHeap();
+    return diagnostics;
+}
+
+#if PB_ENABLE_TLS_PROFILES
+int32_t PocketbaseExtended::measureTlsHandshake(PocketbaseTlsProfile profile, uint8_t runs /* = 3 */)
+{
+    const PocketbaseServer &server = servers[primary_server];
+    if (!server.secure || runs == 0)
+    {
+        return -1;
+    }
+
+    PocketbaseTlsProfile previous = tls_profile;
+    tls_profile = profile;
+
+    // A fresh client per run, so that no session is resumed and every handshake is a full one
+    uint32_t totalMs = 0;
+    int32_t result = 0;
+    for (uint8_t run = 0; run < runs && result >= 0; run++)
+    {
+        std::unique_ptr<PocketbaseSecureClient> client(new PocketbaseSecureClient);
+        configureSecureClient(*client);
+        result = timedConnect(*client, server.host, server.port);
+        client->stop();
+        totalMs += result;
+    }
+
+    tls_profile = previous;
+    return result >= 0 ? (int32_t)(totalMs / runs) : -1;
+}
+
+void PocketbaseExtended::printTlsProfiles(Print &out)
+{
+    static const char *names[] = {"default", "ecdsa-aead", "rsa-aead", "ecdhe-aead"};
+
+    for (uint8_t profile = PB_TLS_DEFAULT; profile <= PB_TLS_ECDHE_AEAD; profile++)
+    {
+        int32_t handshakeMs = measureTlsHandshake((PocketbaseTlsProfile)profile);
+        if (handshakeMs < 0)
+        {
+            out.printf("[PB] tls %-10s refused\n", names[profile]);
+            continue;
+        }
+        out.printf("[PB] tls %-10s handshake=%ldms\n", names[profile], (long)handshakeMs);
+    }
+}
+#endif
+
+void PocketbaseExtended::printDiagnostics(const PocketbaseDiagnostics &diagnostics, Print &out) const
+{
+    const PocketbaseServer &server = servers[primary_server];
+
+    out.printf("[PB] diag %s:%u dns=%ldms tcp=%ldms tls=%ldms tlsResumed=%ldms ttfb=%ldms\n",
+               server.host.c_str(), (unsigned)server.port,
+               (long)diagnostics.dnsMs, (long)diagnostics.tcpConnectMs, (long)diagnostics.tlsFullMs,
+               (long)diagnostics.tlsResumedMs, (long)diagnostics.ttfbMs);
+    out.printf("[PB] diag list=%ldB/%ldms (%ldB/s) heap=%u->%u min=%u\n",
+               (long)diagnostics.listBytes, (long)diagnostics.listMs, (long)diagnostics.listBytesPerSec,
+               (unsigned)diagnostics.heapBefore, (unsigned)diagnostics.heapAfter, (unsigned)diagnostics.minFreeHeap);
+}
+
+String PocketbaseExtended::diagnosticsToJson(const PocketbaseDiagnostics &diagnostics) const
+{
+    String body;
+    body.reserve(320);
+    PocketbaseJsonWriter json(body);
+    json.beginObject();
+    json.field("host", servers[primary_server].host);
+    json.field("dnsMs", (long)diagnostics.dnsMs).field("tcpConnectMs", (long)diagnostics.tcpConnectMs);
+    json.field("tlsFullMs", (long)diagnostics.tlsFullMs).field("tlsResumedMs", (long)diagnostics.tlsResumedMs);
+    json.field("ttfbMs", (long)diagnostics.ttfbMs).field("listMs", (long)diagnostics.listMs);
+    json.field("listBytes", (long)diagnostics.listBytes).field("listBytesPerSec", (long)diagnostics.listBytesPerSec);
+    json.field("heapBefore", (unsigned)diagnostics.heapBefore).field("heapAfter", (unsigned)diagnostics.heapAfter);
+    json.field("minFreeHeap", (unsigned)diagnostics.minFreeHeap);
+    json.endObject();
+    return body;
+}
+
+#endif
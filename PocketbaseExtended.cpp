@@ -1,376 +1,818 @@
-// PocketbaseArduino.cpp
+// PocketbaseExtended.cpp
 
-#include "PocketbaseArduino.h"
-// #include <ESP8266HTTPClient.h>
-// #include <ESP8266WiFi.h>
-// #include <ESP8266HTTPClient.h>
-// #include <BearSSLHelpers.h>
+#include "PocketbaseExtended.h"
 
-#if defined(ESP8266)
-#include <ESP8266HTTPClient.h>
-#include <ESP8266WiFi.h>
-#elif defined(ESP32)
-#include <HTTPClient.h>
-#include <WiFi.h>
-#include <WiFiClientSecure.h>
-#endif
-
-PocketbaseArduino::PocketbaseArduino(const char *baseUrl)
+PocketbaseExtended::PocketbaseExtended(const char *baseUrl)
 {
-    base_url = baseUrl;
+    init();
+    addServer(baseUrl, PB_ROLE_PRIMARY);
+}
 
-    if (base_url.endsWith("/"))
+PocketbaseExtended::PocketbaseExtended(const PocketbaseEndpoint *endpoints, uint8_t count)
+{
+    init();
+    for (uint8_t i = 0; i < count && server_count < PB_MAX_ENDPOINTS; i++)
     {
-        base_url.remove(base_url.length() - 1);
+        addServer(endpoints[i].baseUrl, endpoints[i].role);
     }
+    // Without an explicit primary, writes go to the first endpoint
+    if (primary_server == -1)
+    {
+        primary_server = 0;
+    }
+}
 
-    base_url += "/api/";
+void PocketbaseExtended::init()
+{
+    server_count = 0;
+    primary_server = -1;
 
-    current_endpoint = base_url;
+    current_endpoint = "";
     expand_param = "";
     fields_param = "";
-}
 
-PocketbaseArduino &PocketbaseArduino::collection(const char *collection)
-{
-    current_endpoint = "collections/" + String(collection) + "/";
-    return *this;
+    last_status = 0;
+    request_timeout_ms = 0;
+#if PB_ENABLE_COUNT
+    response_scan_key = nullptr;
+#endif
+    response_secret = false;
+#if PB_ENABLE_TLS_PROFILES
+    tls_profile = PB_TLS_DEFAULT;
+#endif
+    memset(&response_headers, 0, sizeof(response_headers));
+
+#if PB_ENABLE_STATS
+    resetStats();
+#endif
+
+#if PB_ENABLE_SERVER_CLOCK
+    clock_synced = false;
+    clock_offset_low = 0;
+    clock_offset_high = 0;
+    clock_synced_at = 0;
+#endif
+
+#if PB_ENABLE_THROTTLE
+    rate_max_milli = PB_RATE_MAX_MILLI;
+    rate_burst = PB_RATE_BURST;
+#endif
+
+#if PB_ENABLE_TIMEOUT_RETRY
+    timeout_retry_enabled = false;
+    timeout_retry_budget_percent = 0;
+#endif
+
+#if PB_ENABLE_POLL
+    poll_client = nullptr;
+    poll_server = 0;
+    poll_status = PB_POLL_IDLE;
+    poll_code = 0;
+    poll_budget_us = PB_POLL_BUDGET_US;
+    poll_budget_bytes = PB_POLL_BUDGET_BYTES;
+    memset(&poll_stats, 0, sizeof(poll_stats));
+#endif
+
+#if PB_ENABLE_AUTH
+    auth_refreshing = false;
+    auth_refresh_at = 0;
+#endif
 }
 
-String performGETRequest(const char *endpoint)
+void PocketbaseExtended::addServer(const char *baseUrl, PocketbaseEndpointRole role)
 {
+    PocketbaseServer &server = servers[server_count++];
+    if (role == PB_ROLE_PRIMARY && primary_server == -1)
+    {
+        primary_server = server_count - 1;
+    }
 
-#if defined(ESP32)
-    std::unique_ptr<WiFiClientSecure> client(new WiFiClientSecure);
-    client->setInsecure();
-    if (strncmp(url, "https", 5) == 0)
+    server.apiUrl = baseUrl;
+    if (server.apiUrl.endsWith("/"))
     {
-        http.begin(*client, url);
+        server.apiUrl.remove(server.apiUrl.length() - 1);
     }
-    else
+    server.apiUrl += "/api/";
+
+    server.secure = server.apiUrl.startsWith("https://");
+    server.port = server.secure ? 443 : 80;
+
+    int hostStart = server.apiUrl.indexOf("://");
+    hostStart = hostStart == -1 ? 0 : hostStart + 3;
+    int pathStart = server.apiUrl.indexOf('/', hostStart);
+    server.originLength = pathStart;
+
+    server.host = server.apiUrl.substring(hostStart, pathStart);
+    int portStart = server.host.indexOf(':');
+    if (portStart != -1)
     {
-        http.begin(url);
+        server.port = (uint16_t)server.host.substring(portStart + 1).toInt();
+        server.host.remove(portStart);
     }
-#elif defined(ESP8266)
-    if (strncmp(endpoint, "https", 5) == 0)
+
+    server.role = role;
+    server.latencyEwmaMs = 0;
+    server.failures = 0;
+    server.retryAt = 0;
+    server.healthy = true;
+
+#if PB_ENABLE_THROTTLE
+    server.rateMilli = rate_max_milli;
+    server.tokensMilli = rate_burst * 1000;
+    server.refilledAt = millis();
+    server.blockedUntil = 0;
+    server.blocked = false;
+#endif
+}
+
+PocketbaseExtended &PocketbaseExtended::collection(const char *collection)
+{
+    // Reuse the buffer of the previous endpoint instead of building temporaries
+    current_endpoint = "collections/";
+    current_endpoint += collection;
+    current_endpoint += '/';
+    return *this;
+}
+
+int8_t PocketbaseExtended::pickServer(bool write, uint8_t tried) const
+{
+    // Writes only ever go to the primary, there is nowhere else to fail over to
+    if (write)
     {
-        std::unique_ptr<BearSSL::WiFiClientSecure> client(new BearSSL::WiFiClientSecure);
-        client->setInsecure();
-        HTTPClient https;
+        return (tried & (1 << primary_server)) ? -1 : primary_server;
+    }
 
-        Serial.print("[HTTPS] Full URL: ");
-        Serial.println(endpoint);
+    // Reads go to the fastest healthy endpoint. An endpoint without latency sample yet counts as the
+    // fastest so it gets measured, and an unhealthy one is probed again once its back-off has elapsed.
+    uint32_t now = millis();
+    int8_t best = -1;
+    int8_t fallback = -1;
+    for (uint8_t i = 0; i < server_count; i++)
+    {
+        const PocketbaseServer &server = servers[i];
+        if (tried & (1 << i))
+        {
+            continue;
+        }
 
-        if (https.begin(*client, endpoint))
+        if (!server.healthy && (int32_t)(now - server.retryAt) < 0)
         {
-            Serial.print("[HTTPS] GET...\n");
-            int httpCode = https.GET();
-            if (httpCode > 0)
+            if (fallback == -1 || (int32_t)(server.retryAt - servers[fallback].retryAt) < 0)
             {
-                Serial.printf("[HTTPS] GET... code: %d\n", httpCode);
-                // if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY)
-                if (httpCode)
-                {
-                    String payload = https.getString();
-                    // print request contents (must be removed)
-                    Serial.println(payload);
-                    https.end();
-                    return payload;
-                }
+                fallback = i;
             }
-            // else
-            // {
-            //     Serial.printf("[HTTPS] GET... failed, error: %s\n", https.errorToString(httpCode).c_str());
-            // }
-            https.end();
+            continue;
         }
-        else
+
+        if (best == -1 || server.latencyEwmaMs < servers[best].latencyEwmaMs)
         {
-            Serial.printf("[HTTPS] Unable to connect\n");
+            best = i;
         }
-        // TODO: improve return value in case failure happens
-        return ""; // Return an empty string on failure
     }
-    else
+
+    // Every endpoint is backing off: try the one closest to its retry time rather than failing outright
+    return best != -1 ? best : fallback;
+}
+
+// Folds a latency sample into the endpoint average. Alone (ex. for an attempt abandoned after latencyMs),
+// the endpoint looks slower but its health is left as it is.
+void PocketbaseExtended::recordServerLatency(uint8_t index, uint32_t latencyMs)
+{
+    PocketbaseServer &server = servers[index];
+
+    // EWMA with alpha = 1/4, quick enough to follow a degrading link within a few requests
+    server.latencyEwmaMs = server.latencyEwmaMs == 0
+                               ? latencyMs
+                               : (server.latencyEwmaMs * 3 + latencyMs) / 4;
+}
+
+void PocketbaseExtended::markServer(uint8_t index, bool failed, uint32_t latencyMs)
+{
+    PocketbaseServer &server = servers[index];
+
+    if (!failed)
     {
-        Serial.print("[HTTP] Full URL: ");
-        Serial.println(endpoint);
+        recordServerLatency(index, latencyMs);
+        server.failures = 0;
+        server.healthy = true;
+        return;
+    }
 
-        HTTPClient http;
-        Serial.print("[HTTP] begin...\n");
-        if (http.begin(endpoint))
-        {
-            Serial.print("[HTTP] GET...\n");
-            int httpCode = http.GET();
-            if (httpCode > 0)
-            {
-                Serial.printf("[HTTP] GET... code: %d\n", httpCode);
-                // if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY)
-                if (httpCode)
-                {
-                    String payload = http.getString();
-                    Serial.println(payload);
-                    http.end();
-                    return payload;
-                }
-            }
-            // else
-            // {
-            //     Serial.printf("[HTTP] GET... failed, error: %s\n", http.errorToString(httpCode).c_str());
-            // }
-            http.end();
-        }
-        else
-        {
-            Serial.printf("[HTTP] Unable to connect\n");
-        }
-        // TODO: improve return value in case failure happens
-        return ""; // Return an empty string on failure
+    if (server.failures < UINT8_MAX)
+    {
+        server.failures++;
+    }
+    if (server.failures >= PB_ENDPOINT_FAILURE_THRESHOLD)
+    {
+        uint8_t backoff = server.failures - PB_ENDPOINT_FAILURE_THRESHOLD;
+        server.healthy = false;
+        server.retryAt = millis() + (PB_ENDPOINT_RETRY_MS << (backoff < 4 ? backoff : 4));
     }
-#endif
 }
 
-String performDELETERequest(const char *endpoint)
+#if PB_COLLECTED_HEADERS > 0
+// Response headers the library uses. HTTPClient only keeps the headers listed here and drops every
+// other one while parsing, and it stores them in this order, so the index maps a header to its slot.
+static const char *collectedHeaderNames[PB_COLLECTED_HEADERS] = {
+#if PB_KEEP_DATE_HEADER
+    "Date",
+#endif
+#if PB_KEEP_RETRY_AFTER_HEADER
+    "Retry-After",
+#endif
+#if PB_ENABLE_RESPONSE_HEADERS
+    "ETag",
+    "Content-Encoding",
+#endif
+};
+
+// Copies value into the slot of a collected header. A truncated value (ETag...) would be wrong
+// rather than partial, so oversized ones are dropped.
+static void storeHeaderSlot(PocketbaseResponseHeaders &headers, uint8_t index, const char *value, size_t length)
 {
+    struct Slot
+    {
+        char *value;
+        size_t size;
+    };
+    const Slot slots[PB_COLLECTED_HEADERS] = {
+#if PB_KEEP_DATE_HEADER
+        {headers.date, sizeof(headers.date)},
+#endif
+#if PB_KEEP_RETRY_AFTER_HEADER
+        {headers.retryAfter, sizeof(headers.retryAfter)},
+#endif
+#if PB_ENABLE_RESPONSE_HEADERS
+        {headers.etag, sizeof(headers.etag)},
+        {headers.contentEncoding, sizeof(headers.contentEncoding)},
+#endif
+    };
 
-#if defined(ESP32)
-    std::unique_ptr<WiFiClientSecure> client(new WiFiClientSecure);
-    client->setInsecure();
-    if (strncmp(url, "https", 5) == 0)
+    if (length < slots[index].size)
     {
-        http.begin(*client, url);
+        memcpy(slots[index].value, value, length + 1);
     }
     else
     {
-        http.begin(url);
+        slots[index].value[0] = '\0';
     }
-#elif defined(ESP8266)
-    if (strncmp(endpoint, "https", 5) == 0)
+}
+
+void PocketbaseExtended::storeResponseHeaders(HTTPClient &http)
+{
+    for (uint8_t i = 0; i < PB_COLLECTED_HEADERS; i++)
     {
-        std::unique_ptr<BearSSL::WiFiClientSecure> client(new BearSSL::WiFiClientSecure);
-        client->setInsecure();
-        HTTPClient https;
+        const String &value = http.header((size_t)i);
+        storeHeaderSlot(response_headers, i, value.c_str(), value.length());
+    }
+}
+
+void PocketbaseExtended::storeResponseHeader(const char *name, const char *value)
+{
+    for (uint8_t i = 0; i < PB_COLLECTED_HEADERS; i++)
+    {
+        // Header names are case-insensitive
+        if (strcasecmp(name, collectedHeaderNames[i]) == 0)
+        {
+            storeHeaderSlot(response_headers, i, value, strlen(value));
+            return;
+        }
+    }
+}
+#endif
+
+#if PB_ENABLE_RESPONSE_HEADERS
+const PocketbaseResponseHeaders &PocketbaseExtended::lastHeaders() const
+{
+    return response_headers;
+}
+#endif
+
+PocketbaseResponse PocketbaseExtended::performRequest(const char *method, const String &path, const String *requestBody, uint32_t retryAfterMs /* = 0 */)
+{
+#if PB_ENABLE_AUTH
+    // Refresh ahead of expiry so that requests do not pay a 401 round trip in the steady state
+    refreshAuthIfNeeded();
+#endif
 
-        Serial.print("[HTTPS] Full URL: ");
-        Serial.println(endpoint);
+    String payload = dispatchRequest(method, path, requestBody, retryAfterMs);
 
-        if (https.begin(*client, endpoint))
+#if PB_ENABLE_AUTH
+    // The token was revoked or expired early: refresh once and replay the request
+    if (last_status == 401 && auth_token.length() > 0)
+    {
+        PocketbaseResponseHeaders headers = response_headers;
+        if (refreshAuth())
         {
-            Serial.print("[HTTPS] DELETE...\n");
-            int httpCode = https.sendRequest("DELETE");
-            if (httpCode > 0)
-            {
-                Serial.printf("[HTTPS] DELETE... code: %d\n", httpCode);
-                // if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY)
-                if (httpCode)
-                {
-                    String payload = https.getString();
-                    // print request contents (must be removed)
-                    Serial.println(payload);
-                    https.end();
-                    return payload;
-                }
-            }
-            // else
-            // {
-            //     Serial.printf("[HTTPS] GET... failed, error: %s\n", https.errorToString(httpCode).c_str());
-            // }
-            https.end();
+            payload = dispatchRequest(method, path, requestBody, retryAfterMs);
         }
         else
         {
-            Serial.printf("[HTTPS] Unable to connect\n");
+            // The refresh request overwrote them: the caller gets the 401 its own request was answered with
+            last_status = 401;
+            response_headers = headers;
         }
-        // TODO: improve return value in case failure happens
-        return ""; // Return an empty string on failure
     }
-    else
+#endif
+    return PocketbaseResponse(last_status, std::move(payload));
+}
+
+String PocketbaseExtended::dispatchRequest(const char *method, const String &path, const String *requestBody, uint32_t retryAfterMs /* = 0 */)
+{
+    bool write = strcmp(method, "GET") != 0;
+    uint8_t tried = 0;
+    bool attempted = false;
+    String payload;
+    last_status = HTTPC_ERROR_CONNECTION_FAILED;
+
+    int8_t index;
+    while ((index = pickServer(write, tried)) != -1)
     {
-        Serial.print("[HTTP] Full URL: ");
-        Serial.println(endpoint);
+        tried |= 1 << index;
+
+        // Over the rate allowed for this endpoint: try another one rather than adding to its load
+        if (!acquireRequestSlot(servers[index]))
+        {
+            continue;
+        }
+        attempted = true;
+
+        // With a timeout-retry, the first attempt is abandoned once it is slower than retryAfterMs
+        request_timeout_ms = retryAfterMs;
+        retryAfterMs = 0;
 
-        HTTPClient http;
-        Serial.print("[HTTP] begin...\n");
-        if (http.begin(endpoint))
+        uint32_t startedAt = millis();
+        int httpCode = attemptRequest(servers[index], method, path, requestBody, payload);
+        last_status = httpCode;
+
+#if PB_ENABLE_TIMEOUT_RETRY
+        if (request_timeout_ms > 0)
         {
-            Serial.print("[HTTP] DELETE...\n");
-            int httpCode = http.sendRequest("DELETE");
-            if (httpCode > 0)
+            request_timeout_ms = 0;
+            if (httpCode == HTTPC_ERROR_READ_TIMEOUT)
             {
-                Serial.printf("[HTTP] DELETE... code: %d\n", httpCode);
-                // if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY)
-                if (httpCode)
+                // Slow rather than failed, and not a success either: only its latency is recorded. Sent
+                // again on another endpoint when there is one, otherwise on a fresh connection to the same one
+                recordServerLatency(index, millis() - startedAt);
+                request_stats.timeoutRetries++;
+                if (pickServer(write, tried) == -1)
                 {
-                    String payload = http.getString();
-                    Serial.println(payload);
-                    http.end();
-                    return payload;
+                    tried &= ~(1 << index);
                 }
+                PB_LOG("[PB] %s slower than p95 on %s, retrying\n", method, servers[index].host.c_str());
+                continue;
             }
-            // else
-            // {
-            //     Serial.printf("[HTTP] GET... failed, error: %s\n", http.errorToString(httpCode).c_str());
-            // }
-            http.end();
         }
-        else
+#endif
+        adaptRequestRate(servers[index], httpCode);
+
+        // Gateway errors mean the endpoint (or what is behind it) is unavailable, not that the request is wrong
+        bool failed = httpCode <= 0 || httpCode == 502 || httpCode == 503 || httpCode == 504;
+        markServer(index, failed, millis() - startedAt);
+        if (!failed && httpCode != 429)
+        {
+            return payload;
+        }
+
+        if (pickServer(write, tried) != -1)
         {
-            Serial.printf("[HTTP] Unable to connect\n");
+            PB_LOG("[PB] %s failed on %s, failing over\n", method, servers[index].host.c_str());
         }
-        // TODO: improve return value in case failure happens
-        return ""; // Return an empty string on failure
     }
+
+    if (!attempted)
+    {
+        PB_LOG("[PB] %s throttled, not sent\n", method);
+#if PB_ENABLE_STATS
+        request_stats.throttled++;
 #endif
+        last_status = PB_ERROR_THROTTLED;
+    }
+    return payload;
 }
 
-String performPOSTRequest(const char *endpoint, const String &requestBody)
+#if PB_ENABLE_COUNT
+// Reads stream up to "key": and returns the bytes read. The number that follows goes to value, which stays
+// empty when the key is missing. The rest of the response is left unread.
+static size_t scanResponseNumber(Stream &stream, const char *key, String &value)
 {
-#if defined(ESP32)
-    // ESP32 implementation
-    // ...
-#elif defined(ESP8266)
-    std::unique_ptr<BearSSL::WiFiClientSecure> client(new BearSSL::WiFiClientSecure);
-    client->setInsecure();
-    HTTPClient http;
-
-    Serial.print("[HTTPS] Full URL: ");
-    Serial.println(endpoint);
+    size_t keyLength = strlen(key);
+    size_t matched = 0;
+    size_t read = 0;
+    char c;
 
-    if (http.begin(*client, endpoint))
+    value = "";
+    while (stream.readBytes(&c, 1) == 1)
     {
-        Serial.print("[HTTPS] POST...\n");
-
-        int httpCode = http.POST(requestBody);
-        if (httpCode > 0)
+        read++;
+        if (matched == keyLength + 2)
         {
-            Serial.printf("[HTTPS] POST... code: %d\n", httpCode);
-            if (httpCode)
+            // Past the key and its closing quote, up to the colon
+            if (c == ':' || c == ' ')
+            {
+                continue;
+            }
+            if ((c >= '0' && c <= '9') || (c == '-' && value.length() == 0))
             {
-                String payload = http.getString();
-                Serial.println(payload);
-                http.end();
-                return payload;
+                value += c;
+                continue;
             }
+            break;
+        }
+
+        // The key is quoted in the JSON, "key"
+        char expected = matched == 0 || matched == keyLength + 1 ? '"' : key[matched - 1];
+        if (c == expected)
+        {
+            matched++;
         }
         else
         {
-            Serial.printf("[HTTPS] POST... failed, error: %s\n", http.errorToString(httpCode).c_str());
+            matched = c == '"' ? 1 : 0;
         }
+    }
+    return read;
+}
+#endif
 
-        http.end();
+int PocketbaseExtended::attemptRequest(PocketbaseServer &server, const char *method, const String &path, const String *requestBody, String &payload)
+{
+#if PB_ENABLE_COALESCED_WRITES
+    // Requests with a body are written by hand, so that headers and body leave in a single segment
+    if (requestBody != nullptr)
+    {
+        return attemptCoalescedRequest(server, method, path, *requestBody, payload);
+    }
+#endif
+
+#if PB_ENABLE_LOG
+    const char *tag = server.secure ? "[HTTPS]" : "[HTTP]";
+#endif
+
+    String endpoint;
+    endpoint.reserve(server.apiUrl.length() + path.length());
+    endpoint += server.apiUrl;
+    endpoint += path;
+
+    size_t sent = endpoint.length() + (requestBody != nullptr ? requestBody->length() : 0);
+    memset(&response_headers, 0, sizeof(response_headers));
+
+    std::unique_ptr<PocketbaseSecureClient> secureClient;
+    WiFiClient plainClient;
+    HTTPClient http;
+
+    PB_LOG("%s Full URL: %s\n", tag, endpoint.c_str());
+
+    sampleHeap();
+    uint32_t startedAt = millis();
+
+    bool connected;
+    if (server.secure)
+    {
+        secureClient.reset(new PocketbaseSecureClient);
+        configureSecureClient(*secureClient);
+        connected = http.begin(*secureClient, endpoint);
     }
     else
     {
-        Serial.printf("[HTTPS] Unable to connect\n");
+        connected = http.begin(plainClient, endpoint);
     }
 
-    // TODO: improve return value in case of failure
-    return ""; // Return an empty string on failure
-#endif
-}
+    if (request_timeout_ms > 0)
+    {
+        http.setTimeout(request_timeout_ms < UINT16_MAX ? request_timeout_ms : UINT16_MAX);
+    }
 
-String PocketbaseArduino::getOne(const char *recordId, const char *expand /* = nullptr */, const char *fields /* = nullptr */)
-{
-    String fullEndpoint = base_url + String(current_endpoint) + "records/" + recordId;
+    if (!connected)
+    {
+        // begin() only parses the URL, nothing was sent
+        PB_LOG("%s Invalid URL\n", tag);
+        recordRequest(startedAt, sent, 0, true);
+        payload = "";
+        return PB_ERROR_INVALID_URL;
+    }
 
-    // Append the expand parameter if provided
-    if (expand != nullptr && strlen(expand) > 0)
+#if PB_COLLECTED_HEADERS > 0
+    http.collectHeaders(collectedHeaderNames, PB_COLLECTED_HEADERS);
+#endif
+
+#if PB_ENABLE_AUTH
+    if (auth_token.length() > 0)
     {
-        fullEndpoint += "?expand=" + String(expand);
+        http.addHeader("Authorization", auth_token);
     }
+#endif
 
-    // Append the fields parameter if provided
-    if (fields != nullptr && strlen(fields) > 0)
+    PB_LOG("%s %s...\n", tag, method);
+    uint32_t sentAt = millis();
+    int httpCode;
+    if (requestBody != nullptr)
+    {
+        http.addHeader("Content-Type", "application/json");
+        httpCode = http.sendRequest(method, *requestBody);
+    }
+    else
+    {
+        httpCode = http.sendRequest(method);
+    }
+    if (httpCode > 0)
     {
-        // Check if there's already a query string
-        fullEndpoint += (fullEndpoint.indexOf('?') == -1) ? "?" : "&";
-        fullEndpoint += "fields=" + String(fields);
+        PB_LOG("%s %s... code: %d\n", tag, method, httpCode);
+        storeResponseHeaders(http);
+        updateServerClock(sentAt, millis());
+        size_t received;
+#if PB_ENABLE_COUNT
+        if (response_scan_key != nullptr && httpCode == HTTP_CODE_OK && http.getStreamPtr() != nullptr)
+        {
+            received = scanResponseNumber(*http.getStreamPtr(), response_scan_key, payload);
+        }
+        else
+#endif
+        {
+            payload = http.getString();
+            received = payload.length();
+        }
+        sampleHeap();
+#if PB_ENABLE_LOG
+        if (response_secret)
+        {
+            Serial.printf("(%u bytes, not logged)\n", (unsigned)payload.length());
+        }
+        else
+        {
+            Serial.println(payload);
+        }
+#endif
+        http.end();
+        recordRequest(startedAt, sent, received, false);
+        return httpCode;
     }
 
-    return performGETRequest(fullEndpoint.c_str());
+    PB_LOG("%s %s... failed, error: %s\n", tag, method, http.errorToString(httpCode).c_str());
+    http.end();
+    // An attempt abandoned by the timeout-retry was slow, not failed
+    recordRequest(startedAt, sent, 0, !(request_timeout_ms > 0 && httpCode == HTTPC_ERROR_READ_TIMEOUT));
+    // The negative HTTPC_ERROR_* code tells the transport failure apart from an HTTP status
+    payload = "";
+    return httpCode;
 }
 
-String PocketbaseArduino::getList(
-    const char *page /* = nullptr */,
-    const char *perPage /* = nullptr */,
-    const char *sort /* = nullptr */,
-    const char *filter /* = nullptr */,
-    const char *skipTotal /* = nullptr */,
-    const char *expand /* = nullptr */,
-    const char *fields /* = nullptr */)
+#if PB_ENABLE_TIMEOUT_RETRY
+void PocketbaseExtended::setTimeoutRetry(bool enabled, uint8_t budgetPercent /* = 10 */)
 {
-    String fullEndpoint = base_url + String(current_endpoint) + "records/";
+    timeout_retry_enabled = enabled;
+    timeout_retry_budget_percent = budgetPercent;
+}
 
-    // Append the expand parameter if provided
-    if (expand != nullptr && strlen(expand) > 0)
+uint32_t PocketbaseExtended::timeoutRetryDelay() const
+{
+    // Retry only once the latency distribution is known, and within the budget of extra requests
+    if (!timeout_retry_enabled || request_stats.requests < PB_TIMEOUT_RETRY_MIN_SAMPLES ||
+        request_stats.timeoutRetries * 100 >= (uint32_t)timeout_retry_budget_percent * request_stats.requests)
     {
-        fullEndpoint += (fullEndpoint.indexOf('?') == -1) ? "?" : "&";
-        fullEndpoint += "?expand=" + String(expand);
+        return 0;
     }
 
-    // Append the fields parameter if provided
-    if (fields != nullptr && strlen(fields) > 0)
+    uint32_t p95 = latencyPercentile(95);
+    return p95 > PB_TIMEOUT_RETRY_MIN_DELAY_MS ? p95 : PB_TIMEOUT_RETRY_MIN_DELAY_MS;
+}
+#endif
+
+int PocketbaseExtended::lastStatusCode() const
+{
+    return last_status;
+}
+
+// Characters that are passed through query values untouched, everything else is percent-encoded.
+// Keeps PocketBase modifiers (fields=*,description:excerpt(200,true), sort=-created) readable while
+// escaping the spaces, quotes, '&', '=' and '+' that filter expressions are full of.
+static bool isQuerySafe(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '-' || c == '_' || c == '.' || c == '~' || c == ',' || c == '*' ||
+           c == ':' || c == '(' || c == ')' || c == '!' || c == '/' || c == '@';
+}
+
+static bool hasValue(const char *value)
+{
+    return value != nullptr && value[0] != '\0';
+}
+
+// Length of "<sep><name>=<encoded value>", or 0 when the parameter is omitted
+static size_t queryParamLength(const char *name, const char *value)
+{
+    if (!hasValue(value))
     {
-        // Check if there's already a query string
-        fullEndpoint += (fullEndpoint.indexOf('?') == -1) ? "?" : "&";
-        fullEndpoint += "fields=" + String(fields);
+        return 0;
     }
 
-    // Append the page parameter if provided
-    if (page != nullptr && strlen(page) > 0)
+    size_t length = 2 + strlen(name);
+    for (const char *c = value; *c != '\0'; c++)
     {
-        // Check if there's already a query string
-        fullEndpoint += (fullEndpoint.indexOf('?') == -1) ? "?" : "&";
-        fullEndpoint += "page=" + String(page);
+        length += isQuerySafe(*c) ? 1 : 3;
     }
+    return length;
+}
+
+void PocketbaseExtended::appendQueryParam(String &url, bool &hasQuery, const char *name, const char *value)
+{
+    static const char hex[] = "0123456789ABCDEF";
 
-    // Append the perPage parameter if provided
-    if (perPage != nullptr && strlen(perPage) > 0)
+    if (!hasValue(value))
     {
-        // Check if there's already a query string
-        fullEndpoint += (fullEndpoint.indexOf('?') == -1) ? "?" : "&";
-        fullEndpoint += "perPage=" + String(perPage);
+        return;
     }
 
-    // Append the sort parameter if provided
-    if (sort != nullptr && strlen(sort) > 0)
+    url += hasQuery ? '&' : '?';
+    hasQuery = true;
+    url += name;
+    url += '=';
+
+    // Encode into a small stack buffer so the String grows in a few large steps instead of per character
+    char chunk[32];
+    size_t used = 0;
+    for (const char *c = value; *c != '\0'; c++)
     {
-        // Check if there's already a query string
-        fullEndpoint += (fullEndpoint.indexOf('?') == -1) ? "?" : "&";
-        fullEndpoint += "sort=" + String(sort);
+        if (used > sizeof(chunk) - 4)
+        {
+            url.concat(chunk, used);
+            used = 0;
+        }
+
+        if (isQuerySafe(*c))
+        {
+            chunk[used++] = *c;
+        }
+        else
+        {
+            uint8_t b = (uint8_t)*c;
+            chunk[used++] = '%';
+            chunk[used++] = hex[b >> 4];
+            chunk[used++] = hex[b & 0x0F];
+        }
     }
+    url.concat(chunk, used);
+}
+
+String PocketbaseExtended::recordsPath(const char *recordId, size_t queryLength) const
+{
+    size_t idLength = recordId != nullptr ? strlen(recordId) : 0;
 
-    // Append the skipTotal parameter if provided
-    if (skipTotal != nullptr && strlen(skipTotal) > 0)
+    String url;
+    url.reserve(current_endpoint.length() + 8 + idLength + queryLength);
+    url += current_endpoint;
+    url += "records/";
+    if (idLength > 0)
     {
-        // Check if there's already a query string
-        fullEndpoint += (fullEndpoint.indexOf('?') == -1) ? "?" : "&";
-        fullEndpoint += "skipTotal=" + String(skipTotal);
+        url += recordId;
     }
+    return url;
+}
+
+PocketbaseResponse PocketbaseExtended::getOne(const char *recordId, const char *expand /* = nullptr */, const char *fields /* = nullptr */)
+{
+    size_t queryLength = queryParamLength("expand", expand) +
+                         queryParamLength("fields", fields);
+
+    String fullEndpoint = recordsPath(recordId, queryLength);
+    bool hasQuery = false;
+
+    appendQueryParam(fullEndpoint, hasQuery, "expand", expand);
+    appendQueryParam(fullEndpoint, hasQuery, "fields", fields);
+
+    return performRequest("GET", fullEndpoint, nullptr, timeoutRetryDelay());
+}
+
+#if PB_ENABLE_RECORD_ID
+PocketbaseResponse PocketbaseExtended::getOne(const PocketbaseRecordId &recordId, const char *expand /* = nullptr */, const char *fields /* = nullptr */)
+{
+    char id[PB_RECORD_ID_SIZE];
+    recordId.format(id);
+    return getOne(id, expand, fields);
+}
+#endif
+
+PocketbaseResponse PocketbaseExtended::getList(
+    const char *page /* = nullptr */,
+    const char *perPage /* = nullptr */,
+    const char *sort /* = nullptr */,
+    const char *filter /* = nullptr */,
+    const char *skipTotal /* = nullptr */,
+    const char *expand /* = nullptr */,
+    const char *fields /* = nullptr */)
+{
+    return performRequest("GET", listPath(page, perPage, sort, filter, skipTotal, expand, fields), nullptr);
+}
 
-    // Append the filter parameter if provided
-    if (filter != nullptr && strlen(filter) > 0)
+String PocketbaseExtended::listPath(const char *page, const char *perPage, const char *sort, const char *filter,
+                                    const char *skipTotal, const char *expand, const char *fields) const
+{
+    // Size the URL once so building it costs a single allocation
+    size_t queryLength = queryParamLength("expand", expand) +
+                         queryParamLength("fields", fields) +
+                         queryParamLength("page", page) +
+                         queryParamLength("perPage", perPage) +
+                         queryParamLength("sort", sort) +
+                         queryParamLength("skipTotal", skipTotal) +
+                         queryParamLength("filter", filter);
+
+    String fullEndpoint = recordsPath(nullptr, queryLength);
+    bool hasQuery = false;
+
+    appendQueryParam(fullEndpoint, hasQuery, "expand", expand);
+    appendQueryParam(fullEndpoint, hasQuery, "fields", fields);
+    appendQueryParam(fullEndpoint, hasQuery, "page", page);
+    appendQueryParam(fullEndpoint, hasQuery, "perPage", perPage);
+    appendQueryParam(fullEndpoint, hasQuery, "sort", sort);
+    appendQueryParam(fullEndpoint, hasQuery, "skipTotal", skipTotal);
+    appendQueryParam(fullEndpoint, hasQuery, "filter", filter);
+
+    return fullEndpoint;
+}
+
+#if PB_ENABLE_COUNT
+int32_t PocketbaseExtended::count(const char *filter /* = nullptr */)
+{
+    // The total is counted by the server, a single id is enough to get it
+    size_t queryLength = queryParamLength("perPage", "1") +
+                         queryParamLength("fields", "id") +
+                         queryParamLength("filter", filter);
+
+    String fullEndpoint = recordsPath(nullptr, queryLength);
+    bool hasQuery = false;
+
+    appendQueryParam(fullEndpoint, hasQuery, "perPage", "1");
+    appendQueryParam(fullEndpoint, hasQuery, "fields", "id");
+    appendQueryParam(fullEndpoint, hasQuery, "filter", filter);
+
+    response_scan_key = "totalItems";
+    PocketbaseResponse response = performRequest("GET", fullEndpoint, nullptr);
+    response_scan_key = nullptr;
+
+    if (!response.ok() || response.isEmpty())
     {
-        // Check if there's already a query string
-        fullEndpoint += (fullEndpoint.indexOf('?') == -1) ? "?" : "&";
-        fullEndpoint += "skipTotal=" + String(filter);
+        return -1;
     }
+    return strtol(response.c_str(), nullptr, 10);
+}
+#endif
+
+#if PB_ENABLE_AGGREGATE
+PocketbaseResponse PocketbaseExtended::aggregate(const char *field, const char *bucket, const char *filter /* = nullptr */, const char *timeField /* = nullptr */)
+{
+    // current_endpoint is "collections/<name>/", the route takes the bare collection name
+    String path = "pbext/aggregate/";
+    path += current_endpoint.substring(12, current_endpoint.length() - 1);
+    bool hasQuery = false;
 
-    return performGETRequest(fullEndpoint.c_str());
+    appendQueryParam(path, hasQuery, "field", field);
+    appendQueryParam(path, hasQuery, "bucket", bucket);
+    appendQueryParam(path, hasQuery, "timeField", timeField);
+    appendQueryParam(path, hasQuery, "filter", filter);
+
+    return performRequest("GET", path, nullptr);
 }
+#endif
 
-String PocketbaseArduino::deleteRecord(const char *recordId)
+PocketbaseResponse PocketbaseExtended::deleteRecord(const char *recordId)
 {
-    String fullEndpoint = base_url + String(current_endpoint) + "records/" + recordId;
+    String fullEndpoint = recordsPath(recordId, 0);
+
+    return performRequest("DELETE", fullEndpoint, nullptr);
+}
 
-    return performDELETERequest(fullEndpoint.c_str());
+#if PB_ENABLE_RECORD_ID
+PocketbaseResponse PocketbaseExtended::deleteRecord(const PocketbaseRecordId &recordId)
+{
+    char id[PB_RECORD_ID_SIZE];
+    recordId.format(id);
+    return deleteRecord(id);
 }
+#endif
 
-String PocketbaseArduino::create(const String &requestBody)
+PocketbaseResponse PocketbaseExtended::create(const String &requestBody)
 {
     // Construct the endpoint based on the current_endpoint
-    String fullEndpoint = current_endpoint + "records/";
+    String fullEndpoint = recordsPath(nullptr, 0);
+
+    // Call performRequest with the constructed endpoint and provided parameters
+    return performRequest("POST", fullEndpoint, &requestBody);
+}
 
-    // Call performPOSTRequest with the constructed endpoint and provided parameters
-    return performPOSTRequest(fullEndpoint.c_str(), requestBody);
-}
\ No newline at end of file
+#if PB_ENABLE_UPDATE
+PocketbaseResponse PocketbaseExtended::update(const char *recordId, const String &requestBody)
+{
+    String fullEndpoint = recordsPath(recordId, 0);
+
+    return performRequest("PATCH", fullEndpoint, &requestBody);
+}
+
+#if PB_ENABLE_RECORD_ID
+PocketbaseResponse PocketbaseExtended::update(const PocketbaseRecordId &recordId, const String &requestBody)
+{
+    char id[PB_RECORD_ID_SIZE];
+    recordId.format(id);
+    return update(id, requestBody);
+}
+#endif
+#endif
@@ -4,18 +4,333 @@
 #define PocketbaseExtended_h
 
 #include "Arduino.h"
+#include <memory>
 
+#include "PocketbaseConfig.h"
+#include "PocketbaseFilter.h"
+#include "PocketbaseJson.h"
+#include "PocketbaseRecordId.h"
+#if PB_ENABLE_OTA
+#include "PocketbaseOta.h"
+#endif
+
+#if defined(ESP8266)
 #include <ESP8266HTTPClient.h>
 #include <ESP8266WiFi.h>
-#include <ESP8266HTTPClient.h>
-
 #include <BearSSLHelpers.h>
+#elif defined(ESP32)
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#endif
+
+#if defined(ESP8266)
+typedef BearSSL::WiFiClientSecure PocketbaseSecureClient;
+#elif defined(ESP32)
+typedef WiFiClientSecure PocketbaseSecureClient;
+#endif
+
+// WiFiClient::setTimeout() takes seconds on the ESP32 cores before 3.0, milliseconds elsewhere
+#if defined(ESP32) && (!defined(ESP_ARDUINO_VERSION_MAJOR) || ESP_ARDUINO_VERSION_MAJOR < 3)
+#define PB_CLIENT_TIMEOUT(ms) (((ms) + 999) / 1000)
+#else
+#define PB_CLIENT_TIMEOUT(ms) (ms)
+#endif
+
+#if PB_ENABLE_STATS
+// Number of log2 latency buckets kept by PocketbaseStats (1 ms .. ~65 s)
+#define PB_LATENCY_BUCKETS 17
+
+/**
+ * @brief   Counters collected for every request issued by PocketbaseExtended.
+ *
+ *          Used to compare transport strategies (polling interval, page size, TLS on/off...)
+ *          on real links without attaching a profiler. See PocketbaseExtended::stats().
+ */
+struct PocketbaseStats
+{
+    uint32_t requests;      // Requests issued
+    uint32_t failures;      // Requests that did not produce a response (connect or transport error)
+    uint32_t bytesSent;     // Request target and body bytes (headers excluded)
+    uint32_t bytesReceived; // Response body bytes
+    uint32_t lastLatencyMs; // Latency of the last request, connect to end of body
+    uint32_t totalLatencyMs;
+    uint32_t radioOnMs;   // Time spent with a connection open, a proxy for radio energy
+    uint32_t minFreeHeap; // Lowest free heap observed while a request was in flight
+    uint32_t throttled;   // Requests not sent because every endpoint was over its rate limit
+    uint32_t rateLimited; // 429/503 responses received
+    uint32_t timeoutRetries; // getOne attempts abandoned at the p95 latency and sent again
+    uint16_t latencyBuckets[PB_LATENCY_BUCKETS];
+};
+#endif
+
+#if PB_ENABLE_DIAGNOSTICS
+/**
+ * @brief   Result of PocketbaseExtended::runDiagnostics(). Durations are in milliseconds,
+ *          -1 means the step failed or was not applicable (ex.: TLS steps on a plain http base URL).
+ */
+struct PocketbaseDiagnostics
+{
+    int32_t dnsMs;           // Host name resolution
+    int32_t tcpConnectMs;    // Plain TCP handshake to the server port
+    int32_t tlsFullMs;       // TCP + full TLS handshake
+    int32_t tlsResumedMs;    // TCP + TLS handshake resuming the previous session (ESP8266 only)
+    int32_t ttfbMs;          // Request sent to first response byte of a getOne, on an open connection
+    int32_t listMs;          // Request sent to last byte of a getList, on an open connection
+    int32_t listBytes;       // Size of the getList response (headers included)
+    int32_t listBytesPerSec; // Download throughput of the getList
+    uint32_t heapBefore;     // Free heap when the diagnostics started
+    uint32_t heapAfter;      // Free heap when the diagnostics ended
+    uint32_t minFreeHeap;    // Lowest free heap observed while running
+};
+#endif
+
+#if PB_ENABLE_RECONCILE
+// Ranges each digest request splits the id space (or a range that differed) into
+#define PB_RECONCILE_RANGES 32
+// A range that differs is listed when the server holds up to this many ids in it, split further otherwise.
+// Also the page size of the listing, ~24 bytes of response per id.
+#define PB_RECONCILE_LIST_MAX 200
+
+/**
+ * @brief   Called by PocketbaseExtended::reconcile() for every id on which the local copy and the server disagree.
+ *
+ * @param id        The record id.
+ *
+ * @param deleted   True when the id is held locally but no longer on the server, false when the server
+ *                  has a record missing from the local copy.
+ *
+ * @param context   The context given to reconcile().
+ */
+typedef void (*PocketbaseReconcileCallback)(const PocketbaseRecordId &id, bool deleted, void *context);
+
+/**
+ * @brief   Result of PocketbaseExtended::reconcile().
+ */
+struct PocketbaseReconcileResult
+{
+    bool complete;           // False when a request failed, the differences found until then were still reported
+    uint16_t requests;       // Digest and listing requests sent
+    uint16_t rangesCompared; // Range digests compared
+    uint16_t rangesListed;   // Ranges whose ids were listed
+    uint32_t idsListed;      // Ids downloaded while listing
+    uint32_t deleted;        // Ids reported as deleted on the server
+    uint32_t missing;        // Ids reported as missing from the local copy
+};
+#endif
+
+#if PB_ENABLE_POLL
+// Default work allowed to a single poll() call: 2 ms and 1 KB read from the connection, see setPollBudget()
+#define PB_POLL_BUDGET_US 2000
+#define PB_POLL_BUDGET_BYTES 1024
+// Longest status or header line kept by poll(), longer ones are truncated (only their start is looked at)
+#define PB_POLL_LINE_MAX 128
+
+enum PocketbasePollStatus
+{
+    PB_POLL_IDLE,    // No request started, or its response was taken
+    PB_POLL_PENDING, // The response is still arriving, call poll() again
+    PB_POLL_DONE,    // The response is complete, see takeResponse()
+    PB_POLL_FAILED   // No response could be received, takeResponse() carries the error
+};
+
+/**
+ * @brief   Timing of the poll() calls of the last non-blocking request, see PocketbaseExtended::pollStats().
+ *          The interval between two calls is the period of the caller's loop, its jitter tells how steady
+ *          the loop stayed while the response was downloaded.
+ */
+struct PocketbasePollStats
+{
+    uint32_t polls;         // poll() calls while the request was pending
+    uint32_t overBudget;    // Calls that took longer than the time budget (one read can outlast it)
+    uint32_t bytes;         // Bytes read from the connection, headers included
+    uint32_t totalPollUs;   // Time spent reading and parsing in poll()
+    uint32_t maxPollUs;     // Longest call
+    uint32_t minIntervalUs; // Shortest and longest time between the start of two calls
+    uint32_t maxIntervalUs;
+    uint32_t jitterUs;      // Smoothed variation of the interval between calls (RFC 3550 estimator)
+};
+#endif
+
+// Response headers collected from HTTPClient, one slot each in PocketbaseResponseHeaders
+#define PB_COLLECTED_HEADERS (PB_KEEP_DATE_HEADER + PB_KEEP_RETRY_AFTER_HEADER + 2 * PB_ENABLE_RESPONSE_HEADERS)
+
+/**
+ * @brief   Response headers kept from the last request, in fixed-size slots so that nothing from the
+ *          response outlives the request on the heap. Empty when absent or too long for its slot.
+ *          Without PB_ENABLE_RESPONSE_HEADERS, only the slots enabled features read are compiled in.
+ */
+struct PocketbaseResponseHeaders
+{
+#if PB_KEEP_DATE_HEADER
+    char date[30]; // IMF-fixdate, ex.: "Sun, 06 Nov 1994 08:49:37 GMT"
+#endif
+#if PB_KEEP_RETRY_AFTER_HEADER
+    char retryAfter[32]; // Delay in seconds or HTTP date
+#endif
+#if PB_ENABLE_RESPONSE_HEADERS
+    char etag[48];
+    char contentEncoding[16];
+#endif
+};
+
+/**
+ * @brief   Response of a request. It owns the body received by the transport, which is moved rather than copied
+ *          from HTTPClient to the caller, so the handle itself can only be moved. Printable, ex.: Serial.println(response).
+ */
+class PocketbaseResponse : public Printable
+{
+public:
+    PocketbaseResponse();
+    PocketbaseResponse(int statusCode, String &&body);
+
+    PocketbaseResponse(PocketbaseResponse &&other);
+    PocketbaseResponse &operator=(PocketbaseResponse &&other);
+    PocketbaseResponse(const PocketbaseResponse &) = delete;
+    PocketbaseResponse &operator=(const PocketbaseResponse &) = delete;
+
+    // HTTP status, or when no response was received a negative HTTPC_ERROR_* code (transport failure),
+    // PB_ERROR_THROTTLED or PB_ERROR_INVALID_URL
+    int statusCode() const;
+    // True for 2xx statuses
+    bool ok() const;
+
+    // Read-only views of the body, valid until the handle is released, reassigned or destroyed
+    const char *c_str() const;
+    size_t length() const;
+    bool isEmpty() const;
+    const String &body() const;
+
+    // Hands the body over to the caller without copying it, the handle is left empty
+    String release();
+
+    size_t printTo(Print &out) const override;
+
+private:
+    int status_code;
+    String response_body;
+};
+
+#if PB_ENABLE_TLS_PROFILES
+/**
+ * @brief   Cipher suites offered by the TLS clients, see PocketbaseExtended::setTlsProfile(). The key exchange and the server
+ *          certificate signature dominate the handshake cost; every profile but the default keeps forward secrecy (ECDHE)
+ *          and an AEAD cipher, ChaCha20-Poly1305 first since it is faster than AES-GCM without AES hardware.
+ */
+enum PocketbaseTlsProfile : uint8_t
+{
+    PB_TLS_DEFAULT,    // Every suite the core offers, static RSA key exchange and CBC included
+    PB_TLS_ECDSA_AEAD, // ECDHE-ECDSA with ChaCha20-Poly1305 or AES-128-GCM, needs an ECDSA server certificate
+    PB_TLS_RSA_AEAD,   // ECDHE-RSA with ChaCha20-Poly1305 or AES-128-GCM, for RSA server certificates
+    PB_TLS_ECDHE_AEAD, // Both of the above, ECDSA first
+};
+#endif
+
+enum PocketbaseEndpointRole
+{
+    PB_ROLE_PRIMARY,     // Receives writes, and reads when it is the fastest endpoint
+    PB_ROLE_READ_REPLICA // Only receives reads (LAN replica, caching proxy...)
+};
+
+/**
+ * @brief   One server of a multi-endpoint PocketbaseExtended, see the matching constructor.
+ */
+struct PocketbaseEndpoint
+{
+    const char *baseUrl;
+    PocketbaseEndpointRole role;
+};
+
+// Consecutive failures after which an endpoint is considered unhealthy
+#define PB_ENDPOINT_FAILURE_THRESHOLD 2
+// First back-off before an unhealthy endpoint is probed again, doubled on each further failure (up to 16x)
+#define PB_ENDPOINT_RETRY_MS 5000
+
+// Returned by lastStatusCode() when a request was not sent because of the client-side rate limit
+#define PB_ERROR_THROTTLED (-100)
+// Returned by lastStatusCode() when the request URL could not be parsed (ex. no http:// or https:// scheme)
+#define PB_ERROR_INVALID_URL (-101)
+
+// Bytes a TLS record adds to its plaintext at worst: the 5 bytes header, then the explicit IV, MAC and padding of
+// a CBC suite (AES-GCM adds 24, ChaCha20-Poly1305 16). The transmit buffer is sized with it so that a write of
+// PB_TLS_RECORD_SIZE bytes is sealed as a single record whatever the suite.
+#define PB_TLS_RECORD_OVERHEAD 85
+// Plaintext size of the TLS records carrying request bodies. Headers and the start of the body are written as
+// one record, sized so that the record fits in a single TCP segment: TCP_MSS is set by the lwIP variant of the
+// ESP8266 core (536 for its default "Lower Memory", 1460 for "Higher Bandwidth"), 1460 is assumed elsewhere.
+#if defined(TCP_MSS) && TCP_MSS < 1024 + PB_TLS_RECORD_OVERHEAD
+#define PB_TLS_RECORD_SIZE (TCP_MSS - PB_TLS_RECORD_OVERHEAD)
+#else
+#define PB_TLS_RECORD_SIZE 1024
+#endif
+// TLS receive buffer, must hold a full 16 KB record unless the server negotiates a smaller fragment length
+#define PB_TLS_RECEIVE_BUFFER_SIZE 16384
+
+#if PB_ENABLE_THROTTLE
+// Default request rate allowed per endpoint, in thousandths of a request per second
+#define PB_RATE_MAX_MILLI 10000
+// Default number of requests that can be sent back to back
+#define PB_RATE_BURST 5
+// Rate never goes below one request every 20 s, however many 429 are received
+#define PB_RATE_MIN_MILLI 50
+// Additive increase applied to the rate after each successful request
+#define PB_RATE_INCREASE_MILLI 100
+// Longest Retry-After that is honored, protects against a bogus header blocking the device for days
+#define PB_RETRY_AFTER_MAX_MS 3600000UL
+#endif
+
+#if PB_ENABLE_TIMEOUT_RETRY
+// Requests needed before the p95 latency is trusted as a timeout
+#define PB_TIMEOUT_RETRY_MIN_SAMPLES 20
+// Attempts are never abandoned sooner than this, whatever the p95
+#define PB_TIMEOUT_RETRY_MIN_DELAY_MS 100
+#endif
+
+#if PB_ENABLE_AUTH
+// Share of the token lifetime left when it gets refreshed
+#define PB_AUTH_REFRESH_PERCENT 20
+#endif
+
+// State kept for each endpoint
+struct PocketbaseServer
+{
+    String apiUrl; // "scheme://host[:port]/.../api/"
+    String host;
+    uint16_t port;
+    bool secure;
+    int originLength; // Length of "scheme://host[:port]" at the start of apiUrl
+    PocketbaseEndpointRole role;
+    uint32_t latencyEwmaMs; // Smoothed request latency, 0 until the first successful request
+    uint8_t failures;       // Consecutive failures
+    uint32_t retryAt;       // When unhealthy, millis() after which the endpoint is probed again
+    bool healthy;
+
+#if PB_ENABLE_THROTTLE
+    // Token bucket limiting the request rate, adapted with AIMD on 429/503 responses
+    uint32_t rateMilli;    // Allowed rate, in thousandths of a request per second
+    uint32_t tokensMilli;  // Available requests, in thousandths
+    uint32_t refilledAt;   // millis() of the last refill
+    uint32_t blockedUntil; // millis() until which Retry-After asked us to stay away
+    bool blocked;
+#endif
+};
 
 class PocketbaseExtended
 {
 public:
     PocketbaseExtended(const char *baseUrl); // Constructor
 
+    /**
+     * @brief           Creates an instance spread over several servers, ex. a remote primary and a LAN replica or proxy.
+     *                  Writes (create, delete) go to the primary. Reads go to the healthy endpoint with the lowest
+     *                  smoothed latency and fail over to the next one when it errors, times out or answers 502/503/504.
+     *
+     * @param endpoints Base URLs with their role. The first PB_ROLE_PRIMARY one receives writes (the first endpoint if none is).
+     *
+     * @param count     Number of endpoints, up to PB_MAX_ENDPOINTS.
+     */
+    PocketbaseExtended(const PocketbaseEndpoint *endpoints, uint8_t count);
+
     // Methods to build collection and record URLs
     PocketbaseExtended &collection(const char *collection);
 
@@ -37,11 +352,19 @@ public:
      *
      *                  For more information, see: https://pocketbase.io/docs
      */
-    String getOne(
+    PocketbaseResponse getOne(
         const char *recordId,
         const char *expand /* = nullptr */,
         const char *fields /* = nullptr */);
 
+#if PB_ENABLE_RECORD_ID
+    // Same as above, the id is formatted on the stack into the URL
+    PocketbaseResponse getOne(
+        const PocketbaseRecordId &recordId,
+        const char *expand /* = nullptr */,
+        const char *fields /* = nullptr */);
+#endif
+
     /**
      * @brief           Deletes a single record from a Pocketbase collection
      *
@@ -49,7 +372,10 @@ public:
      *
      *                  For more information, see: https://pocketbase.io/docs
      */
-    String deleteRecord(const char *recordId);
+    PocketbaseResponse deleteRecord(const char *recordId);
+#if PB_ENABLE_RECORD_ID
+    PocketbaseResponse deleteRecord(const PocketbaseRecordId &recordId);
+#endif
 
     /**
      * @brief           Fetches a multiple records from a Pocketbase collection. Supports sorting and filtering.
@@ -63,7 +389,8 @@ public:
      *                  `DESC by created and ASC by id`
      *                  `?sort=-created,id`
      *
-     * @param filter    Filter the returned records.
+     * @param filter    Filter the returned records. Ex.: (title~'abc' && created>'2022-01-01')
+     *                  Query values are percent-encoded by the library, pass them unescaped.
      *
      * @param expand    (Optional) Auto expand record relations. Ex.:?expand=relField1,relField2.subRelField Supports up to 6-levels depth nested relations expansion.
      *                  The expanded relations will be appended to the record under the expand property (eg. "expand": {"relField1": {...}, ...}).
@@ -82,7 +409,7 @@ public:
      *
      *                  For more information, see: https://pocketbase.io/docs
      */
-    String getList(
+    PocketbaseResponse getList(
         const char *page /* = nullptr */,
         const char *perPage /* = nullptr */,
         const char *sort /* = nullptr */,
@@ -91,13 +418,511 @@ public:
         const char *expand /* = nullptr */,
         const char *fields /* = nullptr */);
 
-    String create(const String &requestBody);
+    /**
+     * @brief           Creates a record in a Pocketbase collection
+     *
+     * @param requestBody The record as a JSON object, ex. built with PocketbaseJsonWriter.
+     */
+    PocketbaseResponse create(const String &requestBody);
+
+#if PB_ENABLE_UPDATE
+    /**
+     * @brief           Updates the given fields of a record in a Pocketbase collection
+     *
+     * @param recordId  The ID of the record to update.
+     *
+     * @param requestBody The fields to change as a JSON object, ex. built with PocketbaseJsonWriter.
+     */
+    PocketbaseResponse update(const char *recordId, const String &requestBody);
+#if PB_ENABLE_RECORD_ID
+    PocketbaseResponse update(const PocketbaseRecordId &recordId, const String &requestBody);
+#endif
+#endif
+
+#if PB_ENABLE_COUNT
+    /**
+     * @brief           Counts the records of a Pocketbase collection matching a filter, without downloading them.
+     *                  The list is requested with perPage=1&fields=id and the response is only read up to totalItems.
+     *
+     * @param filter    (Optional) Filter the counted records, same syntax as getList().
+     *
+     * @return          The number of records, -1 on failure (see lastStatusCode()).
+     */
+    int32_t count(const char *filter = nullptr);
+#endif
+
+#if PB_ENABLE_AGGREGATE
+    /**
+     * @brief           Computes count/avg/min/max of a numeric field per time bucket on the server, so only one row per
+     *                  bucket is downloaded instead of every record. Requires the pb_hooks/pbext_aggregate.pb.js route
+     *                  shipped with this library to be installed on the server, and an authenticated client.
+     *
+     * @param field     The numeric field to aggregate.
+     *
+     * @param bucket    The bucket size: "minute", "hour", "day", "month" or "year".
+     *
+     * @param filter    (Optional) Filter the aggregated records: comparisons of the collection's own visible fields
+     *                  joined with && and ||, see pb_hooks/pbext_filter.js.
+     *
+     * @param timeField (Optional) The date field used for bucketing (default to "created").
+     *
+     * @return          {"field": ..., "bucket": ..., "items": [["2024-01-20", count, avg, min, max], ...]}
+     */
+    PocketbaseResponse aggregate(
+        const char *field,
+        const char *bucket,
+        const char *filter = nullptr,
+        const char *timeField = nullptr);
+#endif
+
+#if PB_ENABLE_RECONCILE
+    /**
+     * @brief           Finds the differences between a local copy of the current collection and the server, including the
+     *                  records deleted on the server that incremental sync (updated > last) cannot see. The id space is
+     *                  split in ranges whose digest (count and XOR of the id hashes) is compared with the one computed
+     *                  by the server; only the ranges that differ are split further or have their ids listed, so the
+     *                  transfer grows with the number of differences rather than with the collection.
+     *                  Requires the pb_hooks/pbext_digest.pb.js route shipped with this library to be installed on the
+     *                  server, and an authenticated client.
+     *
+     * @param ids       The ids of the local copy, sorted in ascending order and without duplicates.
+     *
+     * @param count     Number of ids.
+     *
+     * @param callback  Called for each id held on only one side, see PocketbaseReconcileCallback.
+     *
+     * @param context   (Optional) Passed to callback.
+     *
+     * @param filter    (Optional) The filter the local copy was synced with: comparisons of the collection's own
+     *                  visible fields joined with && and ||, see pb_hooks/pbext_filter.js.
+     *
+     * @return          What was compared and found, see PocketbaseReconcileResult.
+     */
+    PocketbaseReconcileResult reconcile(
+        const PocketbaseRecordId *ids,
+        size_t count,
+        PocketbaseReconcileCallback callback,
+        void *context = nullptr,
+        const char *filter = nullptr);
+#endif
+
+#if PB_ENABLE_OTA
+    /**
+     * @brief           Updates the firmware from the latest release record of the current collection (see PocketbaseOta.h
+     *                  for its fields). The image is streamed to the sink in PB_OTA_CHUNK_SIZE chunks, never held in RAM;
+     *                  a dropped connection is resumed where it stopped with a Range request, on another endpoint if
+     *                  the current one fails. The size and MD5 given by the record are checked before the sink commits.
+     *
+     * @param sink      Where the image goes, ex. PocketbaseUpdateSink to flash it.
+     *
+     * @param currentVersion The running version, nothing is downloaded when the release has the same one.
+     *
+     * @param filter    (Optional) Restricts the releases considered, ex.: "channel = 'stable' && board = 'esp8266'".
+     *
+     * @return          What happened, see PocketbaseOtaResult. The caller restarts the device after PB_OTA_UPDATED.
+     */
+    PocketbaseOtaResult updateFirmware(PocketbaseFirmwareSink &sink, const char *currentVersion, const char *filter = nullptr);
+#endif
+
+#if PB_ENABLE_POLL
+    /**
+     * @brief           Starts a getList() without waiting for the response, which poll() then reads a slice at a time so
+     *                  that a large list neither stalls loop() nor trips the software watchdog. Connecting, including the
+     *                  TLS handshake, still happens here and blocks; only the response is sliced. A single request is
+     *                  pending at a time, starting one abandons the previous one. Parameters are those of getList().
+     *
+     * @return          false if the request could not be sent (see lastStatusCode()), poll() then returns PB_POLL_FAILED.
+     */
+    bool beginGetList(
+        const char *page /* = nullptr */,
+        const char *perPage /* = nullptr */,
+        const char *sort /* = nullptr */,
+        const char *filter /* = nullptr */,
+        const char *skipTotal /* = nullptr */,
+        const char *expand /* = nullptr */,
+        const char *fields /* = nullptr */);
+
+    /**
+     * @brief           Reads and parses the response of the pending request until the budget set by setPollBudget() is
+     *                  spent or no more bytes are available, then returns. Never waits for the server, call it from loop().
+     *
+     * @return          PB_POLL_PENDING until the response is complete, then PB_POLL_DONE or PB_POLL_FAILED.
+     */
+    PocketbasePollStatus poll();
+
+    /**
+     * @brief           Hands the response over once poll() returned PB_POLL_DONE or PB_POLL_FAILED (the error is then in
+     *                  statusCode()), and goes back to PB_POLL_IDLE. Empty while the request is pending.
+     */
+    PocketbaseResponse takeResponse();
+
+    /**
+     * @brief           Sets how much work a single poll() call may do, whichever limit is reached first ends the call.
+     *
+     * @param maxMicros Time spent reading and parsing per call (default to 2000), 0 for no limit.
+     *
+     * @param maxBytes  Bytes read from the connection per call (default to 1024), 0 for no limit.
+     */
+    void setPollBudget(uint32_t maxMicros, uint32_t maxBytes);
+
+    /**
+     * @brief           Returns the poll() timing of the pending or last request, cleared by beginGetList().
+     */
+    const PocketbasePollStats &pollStats() const;
+
+    /**
+     * @brief           Prints a one line summary of pollStats().
+     *
+     * @param out       Where to print the summary (default to Serial).
+     */
+    void printPollStats(Print &out = Serial) const;
+#endif
+
+    /**
+     * @brief           Status code of the last request: the HTTP status, or a negative HTTPClient error
+     *                  (ex.: HTTPC_ERROR_CONNECTION_FAILED) when no response was received.
+     */
+    int lastStatusCode() const;
+
+#if PB_ENABLE_RESPONSE_HEADERS
+    /**
+     * @brief           Headers of the last response the library keeps (Date, Retry-After, ETag, Content-Encoding).
+     */
+    const PocketbaseResponseHeaders &lastHeaders() const;
+#endif
+
+#if PB_ENABLE_TLS_PROFILES
+    /**
+     * @brief           Restricts the cipher suites offered by every TLS connection, ex. to ECDHE-ECDSA with ChaCha20 or
+     *                  AES-128-GCM only when the server has an ECDSA certificate. The profile must match the server
+     *                  certificate type or handshakes fail; measureTlsHandshake() tells which ones the server accepts and
+     *                  what each costs. Only applied on ESP8266 (BearSSL), the ESP32 client does not expose suite selection.
+     *
+     * @param profile   The suites to offer (default to PB_TLS_DEFAULT).
+     */
+    void setTlsProfile(PocketbaseTlsProfile profile);
+#endif
+
+#if PB_ENABLE_THROTTLE
+    /**
+     * @brief           Sets the client-side rate limit applied to each endpoint (token bucket).
+     *                  On 429 or 503 the rate is halved and Retry-After is honored, then it grows back
+     *                  by PB_RATE_INCREASE_MILLI per successful request (AIMD), so a fleet backs off together
+     *                  instead of amplifying an overload. Requests over the limit are not sent and
+     *                  lastStatusCode() returns PB_ERROR_THROTTLED.
+     *
+     * @param maxPerSecond Highest request rate, per endpoint (default to 10).
+     *
+     * @param burst     Number of requests that can be sent back to back (default to 5).
+     */
+    void setRateLimit(float maxPerSecond, uint8_t burst);
+#endif
+
+#if PB_ENABLE_TIMEOUT_RETRY
+    /**
+     * @brief           Enables a timeout-retry of getOne() for latency critical reads (ex.: polling a command record).
+     *                  When the first attempt has not answered within the p95 latency, it is abandoned and sent again
+     *                  to another endpoint (or on a fresh connection when there is only one). Requests are blocking,
+     *                  so unlike a hedge the two attempts never race: the first one is lost, which pays off when a
+     *                  slow response is a stalled connection rather than a slow server.
+     *
+     * @param enabled   Turns the timeout-retry on or off.
+     *
+     * @param budgetPercent (Optional) Maximum share of requests that can be retried this way (default to 10).
+     */
+    void setTimeoutRetry(bool enabled, uint8_t budgetPercent = 10);
+#endif
+
+#if PB_ENABLE_AUTH
+    /**
+     * @brief           Authenticates with an identity/password pair. The token is then sent with every request and
+     *                  refreshed before it expires, see refreshAuthIfNeeded().
+     *
+     * @param authCollection The auth collection to authenticate against (ex.: "users" or "_superusers").
+     *
+     * @param identity  The username or email of the record.
+     *
+     * @param password  The password of the record.
+     *
+     * @return          The auth response ({"token": ..., "record": {...}}), check ok() for success.
+     */
+    PocketbaseResponse authWithPassword(const char *authCollection, const char *identity, const char *password);
+
+    /**
+     * @brief           Uses an existing token, ex. one persisted across deep sleep.
+     *
+     * @param authCollection The auth collection the token belongs to, used to refresh it.
+     *
+     * @param token     The auth token.
+     */
+    void setAuthToken(const char *authCollection, const char *token);
+
+    /**
+     * @brief           Forgets the auth token, following requests are sent unauthenticated.
+     */
+    void clearAuth();
+
+    /**
+     * @brief           Returns the current auth token, empty when not authenticated.
+     */
+    const String &authToken() const;
+
+    /**
+     * @brief           Refreshes the token when it is in the last PB_AUTH_REFRESH_PERCENT of its lifetime (from the JWT exp claim).
+     *                  Requests call it before going out, call it from loop() to also refresh while idle.
+     *                  A request answered with 401 triggers one refresh and is replayed.
+     *
+     * @return          false if a refresh was due and failed, true otherwise.
+     */
+    bool refreshAuthIfNeeded();
+#endif
+
+#if PB_ENABLE_STATS
+    /**
+     * @brief           Returns the counters collected since construction or the last resetStats() call.
+     */
+    const PocketbaseStats &stats() const;
+
+    /**
+     * @brief           Clears all request counters.
+     */
+    void resetStats();
+
+    /**
+     * @brief           Estimates a latency percentile from the latency histogram.
+     *
+     * @param percentile Percentile to estimate, from 1 to 100 (ex.: 50, 95, 99).
+     *
+     * @return          Estimate in milliseconds, 0 if no request was recorded. The histogram has log2 buckets: the
+     *                  estimate interpolates within the bucket holding the percentile, and can be off by up to the
+     *                  width of that bucket (less than a factor of 2).
+     */
+    uint32_t latencyPercentile(uint8_t percentile) const;
+
+    /**
+     * @brief           Prints a one line summary of the request counters.
+     *
+     * @param out       Where to print the summary (default to Serial).
+     */
+    void printStats(Print &out = Serial) const;
+#endif
+
+#if PB_ENABLE_DIAGNOSTICS
+    /**
+     * @brief           Measures each stage of a request against the server to tell network, server and device bound sites apart.
+     *                  Runs DNS, TCP connect, full and resumed TLS handshakes, the time to first byte of a getOne
+     *                  and the throughput of a getList on the current collection. Takes a few seconds and blocks.
+     *
+     * @param recordId  (Optional) Record of the current collection to use for the time to first byte, skipped if nullptr.
+     *
+     * @param perPage   (Optional) Page size of the getList used for the throughput measurement (default to 200), skipped if nullptr.
+     *
+     * @return          The measurements, see PocketbaseDiagnostics.
+     */
+    PocketbaseDiagnostics runDiagnostics(const char *recordId = nullptr, const char *perPage = "200");
+
+    /**
+     * @brief           Prints a compact diagnostics report.
+     *
+     * @param out       Where to print the report (default to Serial).
+     */
+    void printDiagnostics(const PocketbaseDiagnostics &diagnostics, Print &out = Serial) const;
+
+#if PB_ENABLE_TLS_PROFILES
+    /**
+     * @brief           Measures full TLS handshakes (no session resumption) with the primary endpoint offering only the suites
+     *                  of profile, to pick the cheapest profile the server accepts. Blocks for runs handshakes.
+     *
+     * @param profile   The profile to measure.
+     *
+     * @param runs      (Optional) Number of handshakes averaged (default to 3).
+     *
+     * @return          Average handshake time in milliseconds (TCP connect included), -1 if the server refused the suites
+     *                  or the base URL is not https.
+     */
+    int32_t measureTlsHandshake(PocketbaseTlsProfile profile, uint8_t runs = 3);
+
+    /**
+     * @brief           Measures every TLS profile with measureTlsHandshake() and prints one line per profile.
+     *
+     * @param out       Where to print the comparison (default to Serial).
+     */
+    void printTlsProfiles(Print &out = Serial);
+#endif
+
+    /**
+     * @brief           Serializes diagnostics as a JSON object that can be uploaded with create().
+     *                  Ex.: pb.collection("diagnostics").create(pb.diagnosticsToJson(pb.runDiagnostics()));
+     */
+    String diagnosticsToJson(const PocketbaseDiagnostics &diagnostics) const;
+#endif
+
+#if PB_ENABLE_SERVER_CLOCK
+    /**
+     * @brief           Tells whether the server clock is known, ie. a response carrying a Date header was received.
+     */
+    bool hasServerTime() const;
+
+    /**
+     * @brief           Current server time estimated from the Date header of previous responses, no NTP needed.
+     *                  Every response narrows the estimate, which converges well below the 1 s resolution of the header.
+     *
+     * @return          Milliseconds since the Unix epoch, 0 if hasServerTime() is false.
+     */
+    int64_t serverTimeMs() const;
+
+    /**
+     * @brief           Current server time in the PocketBase date format (YYYY-MM-DD HH:MM:SS.sssZ),
+     *                  to stamp records before calling create(). Empty if hasServerTime() is false.
+     */
+    String serverTimestamp() const;
+#endif
 
 private:
-    String base_url;
+    void init();
+    void addServer(const char *baseUrl, PocketbaseEndpointRole role);
+    int8_t pickServer(bool write, uint8_t tried) const;
+    void markServer(uint8_t index, bool failed, uint32_t latencyMs);
+    void recordServerLatency(uint8_t index, uint32_t latencyMs);
+    String recordsPath(const char *recordId, size_t queryLength) const;
+    String listPath(const char *page, const char *perPage, const char *sort, const char *filter,
+                    const char *skipTotal, const char *expand, const char *fields) const;
+    static void appendQueryParam(String &url, bool &hasQuery, const char *name, const char *value);
+    void configureSecureClient(PocketbaseSecureClient &client) const;
+    PocketbaseResponse performRequest(const char *method, const String &path, const String *requestBody, uint32_t retryAfterMs = 0);
+    String dispatchRequest(const char *method, const String &path, const String *requestBody, uint32_t retryAfterMs = 0);
+    int attemptRequest(PocketbaseServer &server, const char *method, const String &path, const String *requestBody, String &payload);
+    void writeRequestHead(String &request, const PocketbaseServer &server, const char *method, const String &path, const String *requestBody) const;
+#if PB_ENABLE_COALESCED_WRITES
+    int attemptCoalescedRequest(PocketbaseServer &server, const char *method, const String &path, const String &requestBody, String &payload);
+#endif
+#if PB_COLLECTED_HEADERS > 0
+    void storeResponseHeaders(HTTPClient &http);
+    void storeResponseHeader(const char *name, const char *value);
+#else
+    void storeResponseHeaders(HTTPClient &) {}
+    void storeResponseHeader(const char *, const char *) {}
+#endif
+
+    // Hooks called from the request path. The no-op versions of disabled subsystems are inlined away.
+#if PB_ENABLE_STATS
+    void recordRequest(uint32_t startedAt, size_t sent, size_t received, bool failed);
+    void sampleHeap();
+#else
+    void recordRequest(uint32_t, size_t, size_t, bool) {}
+    void sampleHeap() {}
+#endif
+#if PB_ENABLE_SERVER_CLOCK
+    void updateServerClock(uint32_t sentAt, uint32_t receivedAt);
+#else
+    void updateServerClock(uint32_t, uint32_t) {}
+#endif
+#if PB_ENABLE_THROTTLE
+    bool acquireRequestSlot(PocketbaseServer &server);
+    void adaptRequestRate(PocketbaseServer &server, int httpCode);
+    uint32_t retryAfterMs(const char *retryAfter) const;
+#else
+    bool acquireRequestSlot(PocketbaseServer &) { return true; }
+    void adaptRequestRate(PocketbaseServer &, int) {}
+#endif
+#if PB_ENABLE_TIMEOUT_RETRY
+    uint32_t timeoutRetryDelay() const;
+#else
+    uint32_t timeoutRetryDelay() const { return 0; }
+#endif
+#if PB_ENABLE_RECONCILE
+    bool reconcileRanges(const PocketbaseRecordId *ids, size_t count, uint16_t low, uint16_t high, uint8_t ranges,
+                         const char *filter, PocketbaseReconcileCallback callback, void *context,
+                         PocketbaseReconcileResult &result);
+    bool reconcileList(const PocketbaseRecordId *ids, size_t count, uint16_t low, uint16_t high,
+                       const char *filter, PocketbaseReconcileCallback callback, void *context,
+                       PocketbaseReconcileResult &result);
+#endif
+#if PB_ENABLE_OTA
+    PocketbaseOtaResult downloadFirmware(const String &path, size_t size, const char *md5, PocketbaseFirmwareSink &sink);
+#endif
+#if PB_ENABLE_POLL
+    void consumePoll(const char *data, size_t length);
+    void parsePollLine();
+    void finishPoll(int httpCode);
+#endif
+#if PB_ENABLE_AUTH
+    bool refreshAuth();
+    void storeAuthToken(const String &token, const char *dateHeader);
+#endif
+
+    PocketbaseServer servers[PB_MAX_ENDPOINTS];
+    uint8_t server_count;
+    int8_t primary_server;
+
     String current_endpoint;
     String expand_param;
     String fields_param;
+
+    int last_status;
+#if PB_ENABLE_TLS_PROFILES
+    PocketbaseTlsProfile tls_profile;
+#endif
+    uint32_t request_timeout_ms; // Timeout of the next attempt, 0 for HTTPClient's default
+#if PB_ENABLE_COUNT
+    const char *response_scan_key; // When set, a 200 response is only read up to this key, and payload gets its number
+#endif
+    bool response_secret;          // The response carries credentials (auth token), its body is left out of the log
+    PocketbaseResponseHeaders response_headers;
+
+#if PB_ENABLE_STATS
+    PocketbaseStats request_stats;
+#endif
+
+#if PB_ENABLE_SERVER_CLOCK
+    // Range [low, high] of "server epoch ms - local monotonic ms" consistent with every Date header seen
+    bool clock_synced;
+    int64_t clock_offset_low;
+    int64_t clock_offset_high;
+    uint64_t clock_synced_at;
+#endif
+
+#if PB_ENABLE_THROTTLE
+    uint32_t rate_max_milli;
+    uint8_t rate_burst;
+#endif
+
+#if PB_ENABLE_TIMEOUT_RETRY
+    bool timeout_retry_enabled;
+    uint8_t timeout_retry_budget_percent;
+#endif
+
+#if PB_ENABLE_POLL
+    // Connection and parser state of the request driven by poll()
+    std::unique_ptr<PocketbaseSecureClient> poll_secure_client;
+    WiFiClient poll_plain_client;
+    WiFiClient *poll_client; // nullptr when no connection is open
+    int8_t poll_server;
+    PocketbasePollStatus poll_status;
+    uint8_t poll_stage; // Part of the response being read, see PocketbasePoll.cpp
+    int poll_code;
+    bool poll_chunked;
+    size_t poll_remaining; // Body or chunk bytes left, SIZE_MAX until the server closes
+    char poll_line[PB_POLL_LINE_MAX];
+    uint8_t poll_line_length;
+    String poll_body;
+    size_t poll_sent;
+    uint32_t poll_started_at;
+    uint32_t poll_sent_at;
+    uint32_t poll_last_activity;
+    uint32_t poll_budget_us;
+    uint32_t poll_budget_bytes;
+    uint32_t poll_called_at;   // micros() of the previous poll() call
+    uint32_t poll_interval_us; // Interval before the previous call, for the jitter
+    PocketbasePollStats poll_stats;
+#endif
+
+#if PB_ENABLE_AUTH
+    String auth_collection;
+    String auth_token;
+    bool auth_refreshing;     // Set while a refresh is in flight, so it is performed only once
+    uint32_t auth_refresh_at; // millis() from which the token is refreshed, 0 if it never expires
+#endif
 };
 
 #endif
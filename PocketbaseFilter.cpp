@@ -0,0 +1,215 @@
+// PocketbaseFilter.cpp
+
+#include "PocketbaseFilter.h"
+#include <math.h>
+
+PocketbaseReportFilter::PocketbaseReportFilter(const PocketbaseFilterRule *rules, uint8_t fieldCount)
+    : rules(rules), field_count(fieldCount < PB_FILTER_MAX_FIELDS ? fieldCount : PB_FILTER_MAX_FIELDS), previous_at(0)
+{
+    memset(series_table, 0, sizeof(series_table));
+    memset(previous_values, 0, sizeof(previous_values));
+    resetStats();
+}
+
+// 32-bit FNV-1a of the name, 0 is kept for free slots
+uint32_t PocketbaseReportFilter::seriesKey(const char *series)
+{
+    uint32_t hash = 0x811C9DC5UL;
+    for (const char *c = series; *c != '\0'; c++)
+    {
+        hash = (hash ^ (uint8_t)*c) * 0x01000193UL;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+void PocketbaseReportFilter::restart(Series &entry, const float *values, uint32_t at) const
+{
+    memcpy(entry.sent, values, field_count * sizeof(float));
+    memcpy(entry.last, values, field_count * sizeof(float));
+    entry.sentAt = entry.lastAt = at;
+    for (uint8_t i = 0; i < field_count; i++)
+    {
+        entry.slopeLow[i] = -INFINITY;
+        entry.slopeHigh[i] = INFINITY;
+    }
+}
+
+// Narrows the door of a field to the slopes from the pivot that pass within compression of the value
+void PocketbaseReportFilter::narrowDoor(Series &entry, uint8_t field, float value, uint32_t at) const
+{
+    float elapsed = (float)(at - entry.sentAt);
+    float high = (value + rules[field].compression - entry.sent[field]) / elapsed;
+    float low = (value - rules[field].compression - entry.sent[field]) / elapsed;
+    if (high < entry.slopeHigh[field])
+    {
+        entry.slopeHigh[field] = high;
+    }
+    if (low > entry.slopeLow[field])
+    {
+        entry.slopeLow[field] = low;
+    }
+}
+
+PocketbaseReport PocketbaseReportFilter::offer(const char *series, const float *values, uint32_t nowMs /* = millis() */)
+{
+    filter_stats.offered++;
+
+    uint32_t key = seriesKey(series);
+    Series *entry = nullptr;
+    Series *slot = nullptr;
+    for (uint8_t i = 0; i < PB_FILTER_SERIES; i++)
+    {
+        Series &candidate = series_table[i];
+        if (candidate.key == key)
+        {
+            entry = &candidate;
+            break;
+        }
+        // A free slot, or else the series offered least recently
+        if (slot == nullptr || (slot->key != 0 && (candidate.key == 0 || nowMs - candidate.lastAt > nowMs - slot->lastAt)))
+        {
+            slot = &candidate;
+        }
+    }
+
+    if (entry == nullptr)
+    {
+        // First record of the series: always sent, it is the reference for the next ones
+        if (slot->key != 0)
+        {
+            filter_stats.evicted++;
+        }
+        slot->key = key;
+        restart(*slot, values, nowMs);
+        filter_stats.sent++;
+        return PB_REPORT_CURRENT;
+    }
+
+    uint32_t elapsed = nowMs - entry->sentAt;
+    bool heartbeat = false;
+    bool significant = false;
+    bool doorClosed = false;
+    for (uint8_t i = 0; i < field_count; i++)
+    {
+        const PocketbaseFilterRule &rule = rules[i];
+        float value = values[i];
+
+        if (rule.maxIntervalMs > 0 && elapsed >= rule.maxIntervalMs)
+        {
+            heartbeat = true;
+        }
+        if (rule.minIntervalMs > 0 && elapsed < rule.minIntervalMs)
+        {
+            continue;
+        }
+        if (isnan(value) || isnan(entry->sent[i]))
+        {
+            significant |= isnan(value) != isnan(entry->sent[i]);
+            continue;
+        }
+        if (rule.compression <= 0)
+        {
+            significant |= fabsf(value - entry->sent[i]) > rule.deadband;
+            continue;
+        }
+        if (elapsed == 0)
+        {
+            significant |= value != entry->sent[i];
+            continue;
+        }
+
+        narrowDoor(*entry, i, value, nowMs);
+        doorClosed |= entry->slopeLow[i] > entry->slopeHigh[i];
+    }
+
+    if (significant)
+    {
+        restart(*entry, values, nowMs);
+        filter_stats.sent++;
+        return PB_REPORT_CURRENT;
+    }
+
+    if (doorClosed)
+    {
+        // No straight line from the pivot stays within compression of every value since: the last point inside
+        // the door is sent and becomes the pivot, and the door opens again on the offered values. This also
+        // satisfies a heartbeat that is due.
+        memcpy(previous_values, entry->last, field_count * sizeof(float));
+        previous_at = entry->lastAt;
+        restart(*entry, previous_values, previous_at);
+
+        for (uint8_t i = 0; i < field_count; i++)
+        {
+            if (rules[i].compression > 0 && nowMs != entry->sentAt && !isnan(values[i]) && !isnan(entry->sent[i]))
+            {
+                narrowDoor(*entry, i, values[i], nowMs);
+            }
+        }
+        memcpy(entry->last, values, field_count * sizeof(float));
+        entry->lastAt = nowMs;
+        filter_stats.sent++;
+        return PB_REPORT_PREVIOUS;
+    }
+
+    if (heartbeat)
+    {
+        restart(*entry, values, nowMs);
+        filter_stats.heartbeats++;
+        filter_stats.sent++;
+        return PB_REPORT_CURRENT;
+    }
+
+    memcpy(entry->last, values, field_count * sizeof(float));
+    entry->lastAt = nowMs;
+    filter_stats.suppressed++;
+    return PB_REPORT_SUPPRESS;
+}
+
+const float *PocketbaseReportFilter::previous() const
+{
+    return previous_values;
+}
+
+uint32_t PocketbaseReportFilter::previousAt() const
+{
+    return previous_at;
+}
+
+void PocketbaseReportFilter::write(PocketbaseJsonWriter &json, const float *values) const
+{
+    for (uint8_t i = 0; i < field_count; i++)
+    {
+        json.field(rules[i].field, values[i]);
+    }
+}
+
+void PocketbaseReportFilter::forget(const char *series)
+{
+    uint32_t key = seriesKey(series);
+    for (uint8_t i = 0; i < PB_FILTER_SERIES; i++)
+    {
+        if (series_table[i].key == key)
+        {
+            series_table[i].key = 0;
+        }
+    }
+}
+
+const PocketbaseFilterStats &PocketbaseReportFilter::stats() const
+{
+    return filter_stats;
+}
+
+void PocketbaseReportFilter::resetStats()
+{
+    memset(&filter_stats, 0, sizeof(filter_stats));
+}
+
+void PocketbaseReportFilter::printStats(Print &out) const
+{
+    uint32_t suppressedPercent = filter_stats.offered > 0 ? filter_stats.suppressed * 100 / filter_stats.offered : 0;
+
+    out.printf("[PB] filter offered=%u sent=%u suppressed=%u (%u%%) heartbeats=%u evicted=%u\n",
+               (unsigned)filter_stats.offered, (unsigned)filter_stats.sent, (unsigned)filter_stats.suppressed,
+               (unsigned)suppressedPercent, (unsigned)filter_stats.heartbeats, (unsigned)filter_stats.evicted);
+}
@@ -0,0 +1,151 @@
+// PocketbaseFilter.h
+
+#ifndef PocketbaseFilter_h
+#define PocketbaseFilter_h
+
+#include "Arduino.h"
+#include "PocketbaseJson.h"
+
+// Values per record a PocketbaseReportFilter can filter, one PocketbaseFilterRule each
+#ifndef PB_FILTER_MAX_FIELDS
+#define PB_FILTER_MAX_FIELDS 4
+#endif
+// Series whose state a PocketbaseReportFilter keeps, the least recently offered one is dropped for a new one
+#ifndef PB_FILTER_SERIES
+#define PB_FILTER_SERIES 8
+#endif
+
+/**
+ * @brief   How one value of the filtered records decides whether the record is uploaded. Every test is against the
+ *          last value sent for the series, and time is the millis() given to PocketbaseReportFilter::offer().
+ */
+struct PocketbaseFilterRule
+{
+    const char *field;      // Record field holding the value, see PocketbaseReportFilter::write()
+    float deadband;         // Changes up to this are not significant, 0 makes any change significant
+    float compression;      // Swinging door deviation, replaces the deadband: significant once no straight line from
+                            // the last sent value passes within this of every value since. 0 to disable.
+    uint32_t minIntervalMs; // Rate limit: the value is not looked at for this long after a send, 0 to disable
+    uint32_t maxIntervalMs; // Heartbeat: the record is sent at least this often, 0 to disable
+};
+
+enum PocketbaseReport
+{
+    PB_REPORT_SUPPRESS, // Nothing significant changed, do not upload
+    PB_REPORT_CURRENT,  // Upload the offered values
+    PB_REPORT_PREVIOUS  // A swinging door closed: upload the values offered before these, see previous()
+};
+
+/**
+ * @brief   Counters of a PocketbaseReportFilter, see PocketbaseReportFilter::stats().
+ */
+struct PocketbaseFilterStats
+{
+    uint32_t offered;    // Records offered
+    uint32_t sent;       // Records to upload (PB_REPORT_CURRENT and PB_REPORT_PREVIOUS)
+    uint32_t suppressed; // Records filtered out
+    uint32_t heartbeats; // Records sent only because a maxIntervalMs elapsed
+    uint32_t evicted;    // Series dropped from the full table to make room for a new one
+};
+
+/**
+ * @brief   Report-by-exception filter in front of create(): only records whose values changed significantly are
+ *          uploaded. Each value goes through its PocketbaseFilterRule: rate limit, then deadband or swinging door
+ *          compression, and a heartbeat forces a record through when none was sent for too long. A record is sent
+ *          when any of its values is significant. State is kept per series (ex. one per sensor) in a fixed table,
+ *          nothing is allocated.
+ *
+ *          static const PocketbaseFilterRule rules[] = {
+ *              {"temperature", 0, 0.1f, 0, 600000},
+ *              {"humidity", 1.0f, 0, 0, 600000},
+ *          };
+ *          PocketbaseReportFilter filter(rules, 2);
+ *
+ *          float values[] = {temperature, humidity};
+ *          if (filter.offer("room", values) == PB_REPORT_CURRENT) ...
+ */
+class PocketbaseReportFilter
+{
+public:
+    /**
+     * @brief           Creates a filter for records of fieldCount values.
+     *
+     * @param rules     One rule per value, in the order of the values given to offer(). Not copied, must outlive the filter.
+     *
+     * @param fieldCount Number of values per record, up to PB_FILTER_MAX_FIELDS.
+     */
+    PocketbaseReportFilter(const PocketbaseFilterRule *rules, uint8_t fieldCount);
+
+    /**
+     * @brief           Offers the latest values of a series and tells what to upload. The first record of a series is
+     *                  always sent. A NaN value is ignored, except that becoming or ceasing to be NaN is significant.
+     *
+     * @param series    Name of the series, ex. the sensor or device the values come from.
+     *
+     * @param values    One value per rule.
+     *
+     * @param nowMs     (Optional) When the values were read (default to millis()).
+     *
+     * @return          What to upload, see PocketbaseReport.
+     */
+    PocketbaseReport offer(const char *series, const float *values, uint32_t nowMs = millis());
+
+    /**
+     * @brief           Values to upload after PB_REPORT_PREVIOUS, and the millis() they were offered at. The point was
+     *                  read earlier than it is uploaded, so the record should carry its own time field.
+     */
+    const float *previous() const;
+    uint32_t previousAt() const;
+
+    /**
+     * @brief           Writes "field":value for every rule into an open JSON object.
+     */
+    void write(PocketbaseJsonWriter &json, const float *values) const;
+
+    /**
+     * @brief           Drops the state of a series, its next record is sent.
+     */
+    void forget(const char *series);
+
+    /**
+     * @brief           Returns the counters collected since construction or the last resetStats() call.
+     */
+    const PocketbaseFilterStats &stats() const;
+
+    /**
+     * @brief           Clears the counters, the series state is kept.
+     */
+    void resetStats();
+
+    /**
+     * @brief           Prints a one line summary of the counters.
+     *
+     * @param out       Where to print the summary (default to Serial).
+     */
+    void printStats(Print &out = Serial) const;
+
+private:
+    struct Series
+    {
+        uint32_t key;    // Hash of the series name, 0 when the slot is free
+        uint32_t sentAt; // When the last sent values were read, the swinging door pivot
+        uint32_t lastAt; // When the last offered values were read
+        float sent[PB_FILTER_MAX_FIELDS];
+        float last[PB_FILTER_MAX_FIELDS];
+        float slopeLow[PB_FILTER_MAX_FIELDS]; // Swinging door, in value per ms from the pivot
+        float slopeHigh[PB_FILTER_MAX_FIELDS];
+    };
+
+    static uint32_t seriesKey(const char *series);
+    void restart(Series &entry, const float *values, uint32_t at) const;
+    void narrowDoor(Series &entry, uint8_t field, float value, uint32_t at) const;
+
+    const PocketbaseFilterRule *rules;
+    uint8_t field_count;
+    Series series_table[PB_FILTER_SERIES];
+    float previous_values[PB_FILTER_MAX_FIELDS];
+    uint32_t previous_at;
+    PocketbaseFilterStats filter_stats;
+};
+
+#endif
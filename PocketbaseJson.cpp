@@ -0,0 +1,467 @@
+// PocketbaseJson.cpp
+
+#include "PocketbaseJson.h"
+
+#include <math.h>
+
+// "00" to "99", two digits are written per division
+static const char digitPairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const uint32_t powersOf10[10] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+// Writes number backwards ending at end, zero padded to width digits. Returns its first character.
+static char *formatDigits(char *end, uint32_t number, uint8_t width)
+{
+    char *c = end;
+    while (number >= 100)
+    {
+        uint32_t pair = (number % 100) * 2;
+        number /= 100;
+        *--c = digitPairs[pair + 1];
+        *--c = digitPairs[pair];
+    }
+    if (number >= 10)
+    {
+        *--c = digitPairs[number * 2 + 1];
+        *--c = digitPairs[number * 2];
+    }
+    else
+    {
+        *--c = (char)('0' + number);
+    }
+    while (end - c < width)
+    {
+        *--c = '0';
+    }
+    return c;
+}
+
+PocketbaseJsonWriter::PocketbaseJsonWriter(String &json) : output(json), needs_comma(false)
+{
+}
+
+void PocketbaseJsonWriter::separate()
+{
+    if (needs_comma)
+    {
+        output += ',';
+    }
+    needs_comma = true;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::beginObject()
+{
+    separate();
+    output += '{';
+    needs_comma = false;
+    return *this;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::endObject()
+{
+    output += '}';
+    needs_comma = true;
+    return *this;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::beginArray()
+{
+    separate();
+    output += '[';
+    needs_comma = false;
+    return *this;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::endArray()
+{
+    output += ']';
+    needs_comma = true;
+    return *this;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::key(const char *name)
+{
+    value(name);
+    output += ':';
+    needs_comma = false;
+    return *this;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::value(const char *text)
+{
+    if (text == nullptr)
+    {
+        return nullValue();
+    }
+
+    separate();
+    output += '"';
+    // Copy the runs of characters that need no escaping in one piece
+    const char *run = text;
+    for (const char *c = text;; c++)
+    {
+        if (*c != '\0' && *c != '"' && *c != '\\' && (uint8_t)*c >= 0x20)
+        {
+            continue;
+        }
+        if (c > run)
+        {
+            output.concat(run, c - run);
+        }
+        if (*c == '\0')
+        {
+            break;
+        }
+
+        char escaped[7] = {'\\', *c, '\0'};
+        if ((uint8_t)*c < 0x20)
+        {
+            escaped[1] = 'u';
+            escaped[2] = '0';
+            escaped[3] = '0';
+            escaped[4] = "0123456789abcdef"[*c >> 4];
+            escaped[5] = "0123456789abcdef"[*c & 0x0F];
+            escaped[6] = '\0';
+        }
+        output += escaped;
+        run = c + 1;
+    }
+    output += '"';
+    return *this;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::value(const String &text)
+{
+    return value(text.c_str());
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::value(bool flag)
+{
+    separate();
+    output += flag ? "true" : "false";
+    return *this;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::nullValue()
+{
+    separate();
+    output += "null";
+    return *this;
+}
+
+void PocketbaseJsonWriter::writeUnsigned(uint64_t number, bool negative)
+{
+    char buffer[21];
+    char *end = buffer + sizeof(buffer);
+    char *c;
+
+    // 64-bit divisions are done in software, only pay for them above 32 bits
+    if (number <= UINT32_MAX)
+    {
+        c = formatDigits(end, (uint32_t)number, 1);
+    }
+    else
+    {
+        uint64_t high = number / 1000000000;
+        c = formatDigits(end, (uint32_t)(number % 1000000000), 9);
+        if (high > UINT32_MAX)
+        {
+            c = formatDigits(c, (uint32_t)(high % 1000000000), 9);
+            high /= 1000000000;
+        }
+        c = formatDigits(c, (uint32_t)high, 1);
+    }
+    if (negative)
+    {
+        *--c = '-';
+    }
+    output.concat(c, end - c);
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::value(int number)
+{
+    return value((long long)number);
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::value(unsigned int number)
+{
+    separate();
+    writeUnsigned(number, false);
+    return *this;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::value(long number)
+{
+    return value((long long)number);
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::value(unsigned long number)
+{
+    separate();
+    writeUnsigned(number, false);
+    return *this;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::value(long long number)
+{
+    separate();
+    writeUnsigned(number < 0 ? 0 - (uint64_t)number : (uint64_t)number, number < 0);
+    return *this;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::value(unsigned long long number)
+{
+    separate();
+    writeUnsigned(number, false);
+    return *this;
+}
+
+void PocketbaseJsonWriter::writeFloat(double number, uint8_t digits)
+{
+    if (isnan(number) || isinf(number))
+    {
+        output += "null";
+        return;
+    }
+
+    bool negative = number < 0;
+    double magnitude = negative ? -number : number;
+    if (magnitude == 0)
+    {
+        output += '0';
+        return;
+    }
+
+    // Outside of this range the fixed point path below would need more than 32 bits, leave it to printf
+    if (magnitude >= 1e9 || magnitude < 1e-3)
+    {
+        char buffer[32];
+        int precision = digits < 9 ? digits : 9;
+        snprintf(buffer, sizeof(buffer), "%.*g", precision, number);
+        output += buffer;
+        return;
+    }
+
+    // Fixed point with as many decimals as needed for digits significant digits
+    uint32_t integer = (uint32_t)magnitude;
+    uint8_t decimals = digits;
+    if (integer > 0)
+    {
+        uint8_t integerDigits = 1;
+        while (integerDigits < 10 && integer >= powersOf10[integerDigits])
+        {
+            integerDigits++;
+        }
+        decimals = integerDigits < digits ? digits - integerDigits : 0;
+    }
+    else
+    {
+        // Leading zeros of the fraction are not significant
+        for (double scaled = magnitude * 10; scaled < 1 && decimals < 9; scaled *= 10)
+        {
+            decimals++;
+        }
+    }
+    decimals = decimals < 9 ? decimals : 9;
+
+    uint32_t fraction = (uint32_t)((magnitude - integer) * powersOf10[decimals] + 0.5);
+    if (fraction >= powersOf10[decimals])
+    {
+        integer++;
+        fraction -= powersOf10[decimals];
+    }
+    // Shortest form: drop the trailing zeros of the fraction
+    while (decimals > 0 && fraction % 10 == 0)
+    {
+        fraction /= 10;
+        decimals--;
+    }
+
+    char buffer[22];
+    char *end = buffer + sizeof(buffer);
+    char *c = end;
+    if (decimals > 0)
+    {
+        c = formatDigits(c, fraction, decimals);
+        *--c = '.';
+    }
+    c = formatDigits(c, integer, 1);
+    if (negative)
+    {
+        *--c = '-';
+    }
+    output.concat(c, end - c);
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::value(float number)
+{
+    separate();
+    writeFloat(number, PB_JSON_FLOAT_DIGITS);
+    return *this;
+}
+
+PocketbaseJsonWriter &PocketbaseJsonWriter::value(double number)
+{
+    separate();
+    if (isnan(number) || isinf(number))
+    {
+        output += "null";
+        return *this;
+    }
+
+    // The fixed point path stops at 9 digits, a double needs up to 17 to read back the same. 15 keeps short
+    // decimals short (0.1 is not written 0.10000000000000001), 17 is only used when they are not enough.
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.15g", number);
+    if (strtod(buffer, nullptr) != number)
+    {
+        snprintf(buffer, sizeof(buffer), "%.17g", number);
+    }
+    output += buffer;
+    return *this;
+}
+
+// Powers of 10 exactly representable as a float (5^10 < 2^24)
+static const float floatPowersOf10[11] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+
+// Consumes the fraction and exponent of a number, returns past them
+static const char *skipNumberTail(const char *c)
+{
+    if (*c == '.')
+    {
+        c++;
+        while (*c >= '0' && *c <= '9')
+        {
+            c++;
+        }
+    }
+    if (*c == 'e' || *c == 'E')
+    {
+        c++;
+        if (*c == '+' || *c == '-')
+        {
+            c++;
+        }
+        while (*c >= '0' && *c <= '9')
+        {
+            c++;
+        }
+    }
+    return c;
+}
+
+const char *pocketbaseParseFloat(const char *text, float &value)
+{
+    const char *c = text;
+    bool negative = *c == '-';
+    if (negative)
+    {
+        c++;
+    }
+    if (*c < '0' || *c > '9')
+    {
+        return nullptr;
+    }
+
+    // Decimal mantissa and exponent. Past 9 significant digits the mantissa no longer fits, the
+    // digits are dropped and the value is no longer exact.
+    uint32_t mantissa = 0;
+    uint8_t significant = 0;
+    int16_t exponent = 0;
+    bool exact = true;
+    for (; *c >= '0' && *c <= '9'; c++)
+    {
+        if (significant < 9)
+        {
+            mantissa = mantissa * 10 + (*c - '0');
+            significant += mantissa != 0;
+        }
+        else
+        {
+            exponent++;
+            exact = false;
+        }
+    }
+    if (*c == '.')
+    {
+        for (c++; *c >= '0' && *c <= '9'; c++)
+        {
+            if (significant < 9)
+            {
+                mantissa = mantissa * 10 + (*c - '0');
+                significant += mantissa != 0;
+                exponent--;
+            }
+            else
+            {
+                exact = false;
+            }
+        }
+    }
+    if (*c == 'e' || *c == 'E')
+    {
+        const char *exponentStart = c;
+        c++;
+        bool negativeExponent = *c == '-';
+        if (*c == '+' || *c == '-')
+        {
+            c++;
+        }
+        if (*c < '0' || *c > '9')
+        {
+            // "1e" is the number 1 followed by something else
+            c = exponentStart;
+        }
+        else
+        {
+            int16_t written = 0;
+            for (; *c >= '0' && *c <= '9'; c++)
+            {
+                written = written < 1000 ? written * 10 + (*c - '0') : written;
+            }
+            exponent += negativeExponent ? -written : written;
+        }
+    }
+
+    // Exact when both the mantissa and the power of 10 are exact floats, the single rounding of the
+    // multiplication or division is then the correct one (Clinger's fast path)
+    if (exact && mantissa <= (1UL << 24) && exponent >= -10 && exponent <= 10)
+    {
+        float result = (float)mantissa;
+        result = exponent < 0 ? result / floatPowersOf10[-exponent] : result * floatPowersOf10[exponent];
+        value = negative ? -result : result;
+        return c;
+    }
+
+    char *end;
+    value = strtof(text, &end);
+    return end;
+}
+
+const char *pocketbaseParseInt(const char *text, int32_t &value)
+{
+    const char *c = text;
+    bool negative = *c == '-';
+    if (negative)
+    {
+        c++;
+    }
+    if (*c < '0' || *c > '9')
+    {
+        return nullptr;
+    }
+
+    uint32_t magnitude = 0;
+    uint32_t limit = negative ? (uint32_t)INT32_MAX + 1 : (uint32_t)INT32_MAX;
+    for (; *c >= '0' && *c <= '9'; c++)
+    {
+        uint32_t digit = *c - '0';
+        magnitude = magnitude <= (limit - digit) / 10 ? magnitude * 10 + digit : limit;
+    }
+
+    value = negative ? (int32_t)(0 - magnitude) : (int32_t)magnitude;
+    return skipNumberTail(c);
+}
@@ -0,0 +1,82 @@
+// PocketbaseJson.h
+
+#ifndef PocketbaseJson_h
+#define PocketbaseJson_h
+
+#include "Arduino.h"
+
+// Significant digits written for floating point values, same as printf("%.7g") for a float
+#define PB_JSON_FLOAT_DIGITS 7
+
+/**
+ * @brief           Parses the JSON number at text without allocating. Values with a mantissa below 2^24 and a
+ *                  small exponent (ex.: "21.5", "-0.125", "1013.25") take an exact path of one multiplication or
+ *                  division, longer ones fall back to strtof().
+ *
+ * @return          The character following the number, nullptr when text does not start with one.
+ */
+const char *pocketbaseParseFloat(const char *text, float &value);
+
+/**
+ * @brief           Parses the JSON number at text as an integer, saturating at the int32_t range. A fraction is
+ *                  truncated ("3.0" is 3) and an exponent skipped, PocketBase only writes them above 1e21.
+ *
+ * @return          The character following the number, nullptr when text does not start with one.
+ */
+const char *pocketbaseParseInt(const char *text, int32_t &value);
+
+/**
+ * @brief   Appends JSON to a String, ex. the body of create() or update(). Numbers are formatted on the stack
+ *          without printf, and every token is appended in one piece, so the only allocations are the
+ *          String growing (none when it was reserved).
+ *
+ *          String body;
+ *          body.reserve(64);
+ *          PocketbaseJsonWriter json(body);
+ *          json.beginObject();
+ *          json.field("temperature", 21.5f).field("count", 3).field("device", "abc");
+ *          json.endObject();
+ */
+class PocketbaseJsonWriter
+{
+public:
+    explicit PocketbaseJsonWriter(String &json);
+
+    PocketbaseJsonWriter &beginObject();
+    PocketbaseJsonWriter &endObject();
+    PocketbaseJsonWriter &beginArray();
+    PocketbaseJsonWriter &endArray();
+
+    // Writes an object key, the next call writes its value
+    PocketbaseJsonWriter &key(const char *name);
+
+    PocketbaseJsonWriter &value(const char *text); // nullptr is written as null
+    PocketbaseJsonWriter &value(const String &text);
+    PocketbaseJsonWriter &value(bool flag);
+    PocketbaseJsonWriter &value(int number);
+    PocketbaseJsonWriter &value(unsigned int number);
+    PocketbaseJsonWriter &value(long number);
+    PocketbaseJsonWriter &value(unsigned long number);
+    PocketbaseJsonWriter &value(long long number);
+    PocketbaseJsonWriter &value(unsigned long long number);
+    PocketbaseJsonWriter &value(float number); // NaN and infinities are written as null
+    PocketbaseJsonWriter &value(double number); // Reads back as the same double, 17 significant digits at most
+    PocketbaseJsonWriter &nullValue();
+
+    template <typename T>
+    PocketbaseJsonWriter &field(const char *name, T fieldValue)
+    {
+        key(name);
+        return value(fieldValue);
+    }
+
+private:
+    void separate();
+    void writeUnsigned(uint64_t number, bool negative);
+    void writeFloat(double number, uint8_t digits);
+
+    String &output;
+    bool needs_comma;
+};
+
+#endif
@@ -0,0 +1,295 @@
+// PocketbaseOta.cpp
+
+#include "PocketbaseExtended.h"
+
+#if PB_ENABLE_OTA
+
+#include "PocketbaseRecord.h"
+#include <MD5Builder.h>
+#if defined(ESP8266)
+#include <Updater.h>
+#elif defined(ESP32)
+#include <Update.h>
+#endif
+
+// How long a download waits for the next bytes before the connection is considered dropped
+#define PB_OTA_TIMEOUT_MS 10000
+
+bool PocketbaseUpdateSink::begin(size_t size, const char *md5)
+{
+    if (!Update.begin(size))
+    {
+        return false;
+    }
+    return Update.setMD5(md5);
+}
+
+bool PocketbaseUpdateSink::write(const uint8_t *data, size_t length)
+{
+    return Update.write((uint8_t *)data, length) == length;
+}
+
+bool PocketbaseUpdateSink::end()
+{
+    return Update.end();
+}
+
+void PocketbaseUpdateSink::abort()
+{
+#if defined(ESP32)
+    Update.abort();
+#else
+    // Ending an incomplete update discards it, and a complete one fails the MD5 check Update was given
+    Update.end();
+#endif
+}
+
+PocketbaseFileSink::PocketbaseFileSink(fs::File &file) : output(file)
+{
+}
+
+bool PocketbaseFileSink::begin(size_t, const char *)
+{
+    return (bool)output;
+}
+
+bool PocketbaseFileSink::write(const uint8_t *data, size_t length)
+{
+    return output.write(data, length) == length;
+}
+
+bool PocketbaseFileSink::end()
+{
+    output.flush();
+    return true;
+}
+
+void PocketbaseFileSink::abort()
+{
+    // The partial image stays in the file, the caller removes it
+}
+
+// The release record, decoded through a field table like the generated typed records
+struct FirmwareRelease
+{
+    int32_t size;
+    char id[32];
+    char version[32];
+    char file[128];
+    char md5[33];
+};
+
+static const PocketbaseField firmwareReleaseFields[] = {
+    {PB_OTA_SIZE_FIELD, PB_FIELD_INT, false, offsetof(FirmwareRelease, size), sizeof(FirmwareRelease::size)},
+    {"id", PB_FIELD_TEXT, false, offsetof(FirmwareRelease, id), sizeof(FirmwareRelease::id)},
+    {PB_OTA_VERSION_FIELD, PB_FIELD_TEXT, false, offsetof(FirmwareRelease, version), sizeof(FirmwareRelease::version)},
+    {PB_OTA_FILE_FIELD, PB_FIELD_TEXT, false, offsetof(FirmwareRelease, file), sizeof(FirmwareRelease::file)},
+    {PB_OTA_MD5_FIELD, PB_FIELD_TEXT, false, offsetof(FirmwareRelease, md5), sizeof(FirmwareRelease::md5)},
+};
+
+PocketbaseOtaResult PocketbaseExtended::updateFirmware(PocketbaseFirmwareSink &sink, const char *currentVersion, const char *filter /* = nullptr */)
+{
+    PocketbaseResponse response = getList("1", "1", "-created", filter, "1", nullptr,
+                                          "id," PB_OTA_VERSION_FIELD "," PB_OTA_FILE_FIELD "," PB_OTA_SIZE_FIELD "," PB_OTA_MD5_FIELD);
+    if (!response.ok())
+    {
+        return PB_OTA_QUERY_FAILED;
+    }
+
+    // {"items":[{...}],...}, the first item is the latest release
+    const char *item = strstr(response.c_str(), "\"items\"");
+    item = item != nullptr ? strchr(item, '[') : nullptr;
+    item = item != nullptr ? strchr(item, '{') : nullptr;
+
+    FirmwareRelease release;
+    if (item == nullptr ||
+        !pocketbaseDecodeRecord(item, firmwareReleaseFields, sizeof(firmwareReleaseFields) / sizeof(firmwareReleaseFields[0]), &release) ||
+        release.file[0] == '\0' || release.size <= 0 || strlen(release.md5) != 32)
+    {
+        PB_LOG("[OTA] No release\n");
+        return PB_OTA_NO_RELEASE;
+    }
+    if (currentVersion != nullptr && strcmp(release.version, currentVersion) == 0)
+    {
+        PB_LOG("[OTA] %s is up to date\n", currentVersion);
+        return PB_OTA_UP_TO_DATE;
+    }
+    // The body is no longer needed, give it back before the image is downloaded
+    response = PocketbaseResponse();
+
+    // current_endpoint is "collections/<name>/", files are served from "files/<name>/<record id>/<file name>"
+    String path = "files/";
+    path += current_endpoint.substring(12);
+    path += release.id;
+    path += '/';
+    path += release.file;
+
+    PB_LOG("[OTA] Updating to %s (%d bytes)\n", release.version, (int)release.size);
+    return downloadFirmware(path, release.size, release.md5, sink);
+}
+
+PocketbaseOtaResult PocketbaseExtended::downloadFirmware(const String &path, size_t size, const char *md5, PocketbaseFirmwareSink &sink)
+{
+    if (!sink.begin(size, md5))
+    {
+        PB_LOG("[OTA] The sink refused %u bytes\n", (unsigned)size);
+        return PB_OTA_SINK_FAILED;
+    }
+
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[PB_OTA_CHUNK_SIZE]);
+    MD5Builder hash;
+    hash.begin();
+    size_t written = 0;
+
+    for (uint8_t attempt = 0; attempt < PB_OTA_ATTEMPTS && written < size; attempt++)
+    {
+        int8_t index = pickServer(false, 0);
+        PocketbaseServer &server = servers[index];
+
+        String url;
+        url.reserve(server.apiUrl.length() + path.length());
+        url += server.apiUrl;
+        url += path;
+
+        std::unique_ptr<PocketbaseSecureClient> secureClient;
+        WiFiClient plainClient;
+        HTTPClient http;
+
+        sampleHeap();
+        uint32_t startedAt = millis();
+
+        bool connected;
+        if (server.secure)
+        {
+            secureClient.reset(new PocketbaseSecureClient);
+            configureSecureClient(*secureClient);
+#if defined(ESP8266)
+            // Only the receive side needs room for full records, the request is a single GET
+            secureClient->setBufferSizes(PB_TLS_RECEIVE_BUFFER_SIZE, 512);
+#endif
+            connected = http.begin(*secureClient, url);
+        }
+        else
+        {
+            connected = http.begin(plainClient, url);
+        }
+        if (!connected)
+        {
+            markServer(index, true, 0);
+            recordRequest(startedAt, url.length(), 0, true);
+            continue;
+        }
+
+#if PB_ENABLE_AUTH
+        if (auth_token.length() > 0)
+        {
+            http.addHeader("Authorization", auth_token);
+        }
+#endif
+        if (written > 0)
+        {
+            char range[24];
+            snprintf(range, sizeof(range), "bytes=%u-", (unsigned)written);
+            http.addHeader("Range", range);
+        }
+
+        PB_LOG("[OTA] GET %s from byte %u\n", url.c_str(), (unsigned)written);
+        int httpCode = http.GET();
+        last_status = httpCode;
+
+        // A server ignoring the Range header sends the whole image again, the bytes already written are skipped
+        size_t skip = 0;
+        if (httpCode == HTTP_CODE_OK && http.getSize() == (int)size)
+        {
+            skip = written;
+        }
+        else if (httpCode != HTTP_CODE_PARTIAL_CONTENT || http.getSize() != (int)(size - written))
+        {
+            PB_LOG("[OTA] Unexpected answer: %d, %d bytes\n", httpCode, http.getSize());
+            http.end();
+            markServer(index, true, 0);
+            recordRequest(startedAt, url.length(), 0, true);
+            if (httpCode > 0 && httpCode != HTTP_CODE_OK && httpCode != HTTP_CODE_PARTIAL_CONTENT && httpCode < 500)
+            {
+                // 404, 403...: retrying will not help
+                break;
+            }
+            continue;
+        }
+
+        WiFiClient *stream = http.getStreamPtr();
+        size_t received = 0;
+        uint32_t lastActivity = millis();
+        while (written < size && millis() - lastActivity < PB_OTA_TIMEOUT_MS)
+        {
+            int available = stream->available();
+            if (available <= 0)
+            {
+                if (!stream->connected())
+                {
+                    break;
+                }
+                delay(1);
+                continue;
+            }
+
+            size_t wanted = skip > 0 ? skip : size - written;
+            wanted = wanted < PB_OTA_CHUNK_SIZE ? wanted : PB_OTA_CHUNK_SIZE;
+            wanted = wanted < (size_t)available ? wanted : (size_t)available;
+            int read = stream->read(buffer.get(), wanted);
+            if (read <= 0)
+            {
+                continue;
+            }
+            received += read;
+            lastActivity = millis();
+
+            if (skip > 0)
+            {
+                skip -= read;
+                continue;
+            }
+            hash.add(buffer.get(), read);
+            if (!sink.write(buffer.get(), read))
+            {
+                PB_LOG("[OTA] The sink failed at byte %u\n", (unsigned)written);
+                http.end();
+                sink.abort();
+                return PB_OTA_SINK_FAILED;
+            }
+            written += read;
+        }
+        http.end();
+        sampleHeap();
+
+        bool dropped = written < size;
+        if (dropped)
+        {
+            PB_LOG("[OTA] Connection dropped at byte %u of %u\n", (unsigned)written, (unsigned)size);
+            markServer(index, true, 0);
+        }
+        recordRequest(startedAt, url.length(), received, dropped);
+    }
+
+    if (written < size)
+    {
+        sink.abort();
+        return PB_OTA_DOWNLOAD_FAILED;
+    }
+
+    hash.calculate();
+    if (!hash.toString().equalsIgnoreCase(md5))
+    {
+        PB_LOG("[OTA] MD5 mismatch: %s instead of %s\n", hash.toString().c_str(), md5);
+        sink.abort();
+        return PB_OTA_VERIFY_FAILED;
+    }
+    if (!sink.end())
+    {
+        return PB_OTA_SINK_FAILED;
+    }
+    PB_LOG("[OTA] Update written and verified\n");
+    return PB_OTA_UPDATED;
+}
+
+#endif
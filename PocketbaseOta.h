@@ -0,0 +1,97 @@
+// PocketbaseOta.h
+
+#ifndef PocketbaseOta_h
+#define PocketbaseOta_h
+
+#include "Arduino.h"
+#include <FS.h>
+
+/*
+    Firmware releases are records of a collection with these fields (names can be overridden from the build flags):
+    - version: text, compared with the running version
+    - file:    single file, the firmware image (public, protected files need a file token)
+    - size:    number, size of the image in bytes
+    - md5:     text, hex MD5 of the image
+    The most recent record (by created) matching the filter given to updateFirmware() is the release.
+*/
+#ifndef PB_OTA_VERSION_FIELD
+#define PB_OTA_VERSION_FIELD "version"
+#endif
+#ifndef PB_OTA_FILE_FIELD
+#define PB_OTA_FILE_FIELD "file"
+#endif
+#ifndef PB_OTA_SIZE_FIELD
+#define PB_OTA_SIZE_FIELD "size"
+#endif
+#ifndef PB_OTA_MD5_FIELD
+#define PB_OTA_MD5_FIELD "md5"
+#endif
+
+// Bytes read from the connection and handed to the sink at once
+#define PB_OTA_CHUNK_SIZE 1024
+// Connections opened for one update, each one resuming where the previous one dropped (Range request)
+#define PB_OTA_ATTEMPTS 5
+
+enum PocketbaseOtaResult
+{
+    PB_OTA_UPDATED,         // The image was written and verified, restart to boot it
+    PB_OTA_UP_TO_DATE,      // The latest release is the running version
+    PB_OTA_NO_RELEASE,      // No record matches, or it has no file/size/md5
+    PB_OTA_QUERY_FAILED,    // The release could not be queried (see lastStatusCode())
+    PB_OTA_DOWNLOAD_FAILED, // Every attempt dropped before the end of the image
+    PB_OTA_SINK_FAILED,     // The sink refused the image (too large, flash write error...)
+    PB_OTA_VERIFY_FAILED    // Size or MD5 mismatch, nothing was committed
+};
+
+/**
+ * @brief   Destination of a firmware image downloaded by PocketbaseExtended::updateFirmware(). Bytes arrive in order
+ *          and exactly once, also across resumed connections, and the image is only committed by end() once its MD5
+ *          has been verified.
+ */
+class PocketbaseFirmwareSink
+{
+public:
+    virtual ~PocketbaseFirmwareSink() {}
+
+    // Called before the first byte with the size and hex MD5 of the image, false aborts the update
+    virtual bool begin(size_t size, const char *md5) = 0;
+    // Writes the next bytes of the image, false aborts the update
+    virtual bool write(const uint8_t *data, size_t length) = 0;
+    // The whole image was written and verified: commit it
+    virtual bool end() = 0;
+    // The download failed or did not verify: drop what was written
+    virtual void abort() = 0;
+};
+
+/**
+ * @brief   Writes the image to the OTA partition through the core Update API. The MD5 is also handed to Update,
+ *          so the core itself refuses to commit a mismatching image. After PB_OTA_UPDATED, ESP.restart() boots it.
+ */
+class PocketbaseUpdateSink : public PocketbaseFirmwareSink
+{
+public:
+    bool begin(size_t size, const char *md5) override;
+    bool write(const uint8_t *data, size_t length) override;
+    bool end() override;
+    void abort() override;
+};
+
+/**
+ * @brief   Writes the image to a file (LittleFS, SD...), ex. to stage it or to test a release without flashing it.
+ *          The file must be open for writing, it is left open.
+ */
+class PocketbaseFileSink : public PocketbaseFirmwareSink
+{
+public:
+    explicit PocketbaseFileSink(fs::File &file);
+
+    bool begin(size_t size, const char *md5) override;
+    bool write(const uint8_t *data, size_t length) override;
+    bool end() override;
+    void abort() override;
+
+private:
+    fs::File &output;
+};
+
+#endif
@@ -0,0 +1,395 @@
+// PocketbasePoll.cpp
+
+#include "PocketbaseExtended.h"
+
+#if PB_ENABLE_POLL
+
+// How long a pending request waits for the next bytes before giving up, same as the blocking transport
+#define PB_POLL_TIMEOUT_MS 5000
+// Bytes read from the connection at once
+#define PB_POLL_READ_SIZE 128
+
+// Part of the response poll() is reading
+enum PollStage : uint8_t
+{
+    POLL_STATUS,           // Status line
+    POLL_HEADERS,          // Header lines, up to the empty one
+    POLL_BODY,             // Content-Length body, poll_remaining bytes left
+    POLL_BODY_UNTIL_CLOSE, // Body without length, ends when the server closes
+    POLL_CHUNK_SIZE,       // Hex size line of the next chunk
+    POLL_CHUNK_DATA,       // Chunk bytes, poll_remaining left
+    POLL_CHUNK_END         // CRLF closing a chunk
+};
+
+bool PocketbaseExtended::beginGetList(
+    const char *page /* = nullptr */,
+    const char *perPage /* = nullptr */,
+    const char *sort /* = nullptr */,
+    const char *filter /* = nullptr */,
+    const char *skipTotal /* = nullptr */,
+    const char *expand /* = nullptr */,
+    const char *fields /* = nullptr */)
+{
+    if (poll_client != nullptr)
+    {
+        PB_LOG("[PB] Abandoning the pending request\n");
+        poll_client->stop();
+        poll_client = nullptr;
+        poll_secure_client.reset();
+    }
+    poll_body = String();
+    memset(&poll_stats, 0, sizeof(poll_stats));
+    memset(&response_headers, 0, sizeof(response_headers));
+
+#if PB_ENABLE_AUTH
+    refreshAuthIfNeeded();
+#endif
+
+    String path = listPath(page, perPage, sort, filter, skipTotal, expand, fields);
+
+    // No failover once the response is being read, the caller starts the request again if it fails
+    poll_server = pickServer(false, 0);
+    PocketbaseServer &server = servers[poll_server];
+    if (!acquireRequestSlot(server))
+    {
+        PB_LOG("[PB] GET throttled, not sent\n");
+#if PB_ENABLE_STATS
+        request_stats.throttled++;
+#endif
+        last_status = poll_code = PB_ERROR_THROTTLED;
+        poll_status = PB_POLL_FAILED;
+        return false;
+    }
+
+    String request;
+    writeRequestHead(request, server, "GET", path, nullptr);
+    poll_sent = request.length();
+
+    PB_LOG("%s Full URL: %s%s\n", server.secure ? "[HTTPS]" : "[HTTP]", server.apiUrl.c_str(), path.c_str());
+
+    if (server.secure)
+    {
+        poll_secure_client.reset(new PocketbaseSecureClient);
+        configureSecureClient(*poll_secure_client);
+#if defined(ESP8266)
+        // Only the receive side needs room for full records, the request is a single GET
+        poll_secure_client->setBufferSizes(PB_TLS_RECEIVE_BUFFER_SIZE, 512);
+#endif
+        poll_client = poll_secure_client.get();
+    }
+    else
+    {
+        poll_client = &poll_plain_client;
+    }
+    poll_client->setTimeout(PB_CLIENT_TIMEOUT(PB_POLL_TIMEOUT_MS));
+
+    poll_status = PB_POLL_PENDING;
+    poll_stage = POLL_STATUS;
+    poll_code = 0;
+    poll_chunked = false;
+    poll_remaining = SIZE_MAX;
+    poll_line_length = 0;
+
+    sampleHeap();
+    poll_started_at = millis();
+
+    if (!poll_client->connect(server.host.c_str(), server.port))
+    {
+        finishPoll(HTTPC_ERROR_CONNECTION_FAILED);
+        return false;
+    }
+    // The socket only exists once connected, setting the option earlier would not reach it
+    poll_client->setNoDelay(true);
+    if (poll_client->write((const uint8_t *)request.c_str(), request.length()) != request.length())
+    {
+        finishPoll(HTTPC_ERROR_SEND_HEADER_FAILED);
+        return false;
+    }
+
+    poll_sent_at = poll_last_activity = millis();
+    return true;
+}
+
+PocketbasePollStatus PocketbaseExtended::poll()
+{
+    if (poll_status != PB_POLL_PENDING)
+    {
+        return poll_status;
+    }
+
+    uint32_t calledAt = micros();
+    if (poll_stats.polls > 0)
+    {
+        uint32_t interval = calledAt - poll_called_at;
+        if (poll_stats.polls == 1 || interval < poll_stats.minIntervalUs)
+        {
+            poll_stats.minIntervalUs = interval;
+        }
+        if (interval > poll_stats.maxIntervalUs)
+        {
+            poll_stats.maxIntervalUs = interval;
+        }
+        if (poll_stats.polls > 1)
+        {
+            // J += (|D| - J) / 16, D being the change of the interval from one call to the next
+            int32_t change = (int32_t)(interval - poll_interval_us);
+            int32_t deviation = change < 0 ? -change : change;
+            poll_stats.jitterUs += (deviation - (int32_t)poll_stats.jitterUs) / 16;
+        }
+        poll_interval_us = interval;
+    }
+    poll_called_at = calledAt;
+    poll_stats.polls++;
+
+    uint8_t buffer[PB_POLL_READ_SIZE];
+    uint32_t bytes = 0;
+    while (poll_status == PB_POLL_PENDING)
+    {
+        if ((poll_budget_us > 0 && micros() - calledAt >= poll_budget_us) ||
+            (poll_budget_bytes > 0 && bytes >= poll_budget_bytes))
+        {
+            break;
+        }
+
+        int available = poll_client->available();
+        if (available <= 0)
+        {
+            // Nothing to read yet: give the time back to the caller rather than wait for it
+            if (!poll_client->connected())
+            {
+                finishPoll(poll_stage == POLL_BODY_UNTIL_CLOSE ? poll_code : HTTPC_ERROR_CONNECTION_LOST);
+            }
+            else if (millis() - poll_last_activity >= PB_POLL_TIMEOUT_MS)
+            {
+                finishPoll(HTTPC_ERROR_READ_TIMEOUT);
+            }
+            break;
+        }
+
+        size_t wanted = sizeof(buffer);
+        wanted = wanted < (size_t)available ? wanted : (size_t)available;
+        if (poll_budget_bytes > 0 && wanted > poll_budget_bytes - bytes)
+        {
+            wanted = poll_budget_bytes - bytes;
+        }
+        int read = poll_client->read(buffer, wanted);
+        if (read <= 0)
+        {
+            break;
+        }
+        bytes += read;
+        poll_last_activity = millis();
+        consumePoll((const char *)buffer, read);
+    }
+
+    uint32_t elapsed = micros() - calledAt;
+    poll_stats.bytes += bytes;
+    poll_stats.totalPollUs += elapsed;
+    if (elapsed > poll_stats.maxPollUs)
+    {
+        poll_stats.maxPollUs = elapsed;
+    }
+    if (poll_budget_us > 0 && elapsed > poll_budget_us)
+    {
+        poll_stats.overBudget++;
+    }
+    return poll_status;
+}
+
+void PocketbaseExtended::consumePoll(const char *data, size_t length)
+{
+    while (length > 0 && poll_status == PB_POLL_PENDING)
+    {
+        if (poll_stage == POLL_BODY || poll_stage == POLL_CHUNK_DATA || poll_stage == POLL_BODY_UNTIL_CLOSE)
+        {
+            size_t taken = length < poll_remaining ? length : poll_remaining;
+            poll_body.concat(data, taken);
+            data += taken;
+            length -= taken;
+
+            if (poll_stage != POLL_BODY_UNTIL_CLOSE && (poll_remaining -= taken) == 0)
+            {
+                if (poll_stage == POLL_BODY)
+                {
+                    finishPoll(poll_code);
+                }
+                else
+                {
+                    poll_stage = POLL_CHUNK_END;
+                }
+            }
+            continue;
+        }
+
+        // Status, header and chunk size lines are collected across calls, the line ends at LF
+        char c = *data++;
+        length--;
+        if (c != '\n')
+        {
+            if (poll_line_length < PB_POLL_LINE_MAX - 1)
+            {
+                poll_line[poll_line_length++] = c;
+            }
+            continue;
+        }
+        if (poll_line_length > 0 && poll_line[poll_line_length - 1] == '\r')
+        {
+            poll_line_length--;
+        }
+        poll_line[poll_line_length] = '\0';
+        poll_line_length = 0;
+        parsePollLine();
+    }
+}
+
+void PocketbaseExtended::parsePollLine()
+{
+    char *line = poll_line;
+
+    switch (poll_stage)
+    {
+    case POLL_STATUS:
+        if (strncmp(line, "HTTP/1.", 7) != 0 || line[8] != ' ')
+        {
+            finishPoll(HTTPC_ERROR_NO_HTTP_SERVER);
+            return;
+        }
+        poll_code = atoi(line + 9);
+        poll_stage = POLL_HEADERS;
+        break;
+
+    case POLL_HEADERS:
+        if (line[0] == '\0')
+        {
+            updateServerClock(poll_sent_at, millis());
+            if (poll_chunked)
+            {
+                poll_stage = POLL_CHUNK_SIZE;
+            }
+            else if (poll_remaining == SIZE_MAX)
+            {
+                poll_stage = POLL_BODY_UNTIL_CLOSE;
+            }
+            else if (poll_remaining == 0)
+            {
+                finishPoll(poll_code);
+            }
+            else
+            {
+                poll_body.reserve(poll_remaining);
+                poll_stage = POLL_BODY;
+            }
+        }
+        else
+        {
+            char *value = strchr(line, ':');
+            if (value == nullptr)
+            {
+                break;
+            }
+            *value++ = '\0';
+            while (*value == ' ')
+            {
+                value++;
+            }
+
+            if (strcasecmp(line, "Content-Length") == 0)
+            {
+                poll_remaining = strtoul(value, nullptr, 10);
+            }
+            else if (strcasecmp(line, "Transfer-Encoding") == 0)
+            {
+                poll_chunked = strstr(value, "chunked") != nullptr;
+            }
+            else
+            {
+                storeResponseHeader(line, value);
+            }
+        }
+        break;
+
+    case POLL_CHUNK_SIZE:
+        // A zero size chunk ends the body, trailers are not read
+        poll_remaining = strtoul(line, nullptr, 16);
+        if (poll_remaining == 0)
+        {
+            finishPoll(poll_code);
+        }
+        else
+        {
+            poll_stage = POLL_CHUNK_DATA;
+        }
+        break;
+
+    case POLL_CHUNK_END:
+        poll_stage = POLL_CHUNK_SIZE;
+        break;
+    }
+}
+
+void PocketbaseExtended::finishPoll(int httpCode)
+{
+#if PB_ENABLE_LOG
+    const char *tag = servers[poll_server].secure ? "[HTTPS]" : "[HTTP]";
+#endif
+
+    poll_client->stop();
+    poll_client = nullptr;
+    // The TLS buffers are the bulk of the request's memory, free them now rather than on the next request
+    poll_secure_client.reset();
+    sampleHeap();
+
+    last_status = poll_code = httpCode;
+    uint32_t latencyMs = millis() - poll_started_at;
+
+    if (httpCode > 0)
+    {
+        PB_LOG("%s GET... code: %d, %u bytes in %u polls\n", tag, httpCode,
+               (unsigned)poll_body.length(), (unsigned)poll_stats.polls);
+        adaptRequestRate(servers[poll_server], httpCode);
+        markServer(poll_server, httpCode == 502 || httpCode == 503 || httpCode == 504, latencyMs);
+        recordRequest(poll_started_at, poll_sent, poll_body.length(), false);
+        poll_status = PB_POLL_DONE;
+        return;
+    }
+
+    PB_LOG("%s GET... failed, error: %s\n", tag, HTTPClient::errorToString(httpCode).c_str());
+    markServer(poll_server, true, latencyMs);
+    recordRequest(poll_started_at, poll_sent, 0, true);
+    poll_body = String();
+    poll_status = PB_POLL_FAILED;
+}
+
+PocketbaseResponse PocketbaseExtended::takeResponse()
+{
+    if (poll_status != PB_POLL_DONE && poll_status != PB_POLL_FAILED)
+    {
+        return PocketbaseResponse();
+    }
+    poll_status = PB_POLL_IDLE;
+    return PocketbaseResponse(poll_code, std::move(poll_body));
+}
+
+void PocketbaseExtended::setPollBudget(uint32_t maxMicros, uint32_t maxBytes)
+{
+    poll_budget_us = maxMicros;
+    poll_budget_bytes = maxBytes;
+}
+
+const PocketbasePollStats &PocketbaseExtended::pollStats() const
+{
+    return poll_stats;
+}
+
+void PocketbaseExtended::printPollStats(Print &out) const
+{
+    uint32_t avg = poll_stats.polls > 0 ? poll_stats.totalPollUs / poll_stats.polls : 0;
+
+    out.printf("[PB] polls=%u bytes=%u avg=%uus max=%uus overBudget=%u interval=%u..%uus jitter=%uus\n",
+               (unsigned)poll_stats.polls, (unsigned)poll_stats.bytes, (unsigned)avg,
+               (unsigned)poll_stats.maxPollUs, (unsigned)poll_stats.overBudget,
+               (unsigned)poll_stats.minIntervalUs, (unsigned)poll_stats.maxIntervalUs,
+               (unsigned)poll_stats.jitterUs);
+}
+
+#endif
@@ -0,0 +1,286 @@
+// PocketbaseReconcile.cpp
+
+#include "PocketbaseExtended.h"
+
+#if PB_ENABLE_RECONCILE
+
+static const char digits36[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+// First index of ids (sorted) whose prefix is at least prefix
+static size_t lowerBound(const PocketbaseRecordId *ids, size_t count, uint32_t prefix)
+{
+    size_t first = 0;
+    while (count > 0)
+    {
+        size_t half = count / 2;
+        if (ids[first + half].prefix() < prefix)
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
+    }
+    return first;
+}
+
+// First prefix of range index out of ranges splitting [low, high), the inverse of the
+// floor((p - low) * ranges / (high - low)) the route uses to place an id
+static uint32_t rangeStart(uint32_t low, uint32_t high, uint8_t ranges, uint8_t index)
+{
+    return low + ((high - low) * index + ranges - 1) / ranges;
+}
+
+// 32-bit FNV-1a of the id text, the hash the route XORs into its digests
+static uint32_t idHash(const PocketbaseRecordId &id)
+{
+    char text[PB_RECORD_ID_SIZE];
+    id.format(text);
+
+    uint32_t hash = 0x811C9DC5UL;
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        hash = (hash ^ (uint8_t)*c) * 0x01000193UL;
+    }
+    return hash;
+}
+
+// Appends "<operator> '<smallest id with prefix>'" to filter
+static void appendIdBound(String &filter, const char *op, uint32_t prefix)
+{
+    char bound[PB_RECORD_ID_SIZE + 2] = "'000000000000000'";
+    bound[1] = digits36[prefix / (36 * 36)];
+    bound[2] = digits36[prefix / 36 % 36];
+    bound[3] = digits36[prefix % 36];
+
+    filter += " && id ";
+    filter += op;
+    filter += ' ';
+    filter += bound;
+}
+
+static void reportIds(const PocketbaseRecordId *ids, size_t count, bool deleted, PocketbaseReconcileCallback callback,
+                      void *context, PocketbaseReconcileResult &result)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        callback(ids[i], deleted, context);
+    }
+    if (deleted)
+    {
+        result.deleted += count;
+    }
+    else
+    {
+        result.missing += count;
+    }
+}
+
+PocketbaseReconcileResult PocketbaseExtended::reconcile(
+    const PocketbaseRecordId *ids,
+    size_t count,
+    PocketbaseReconcileCallback callback,
+    void *context /* = nullptr */,
+    const char *filter /* = nullptr */)
+{
+    PocketbaseReconcileResult result = {};
+    result.complete = reconcileRanges(ids, count, 0, PB_RECORD_ID_PREFIXES, PB_RECONCILE_RANGES,
+                                      filter, callback, context, result);
+
+    PB_LOG("[PB] Reconciled %u ids: %u requests, %u ranges listed, %u ids listed, %u deleted, %u missing%s\n",
+           (unsigned)count, result.requests, result.rangesListed, (unsigned)result.idsListed,
+           (unsigned)result.deleted, (unsigned)result.missing, result.complete ? "" : " (incomplete)");
+    return result;
+}
+
+bool PocketbaseExtended::reconcileRanges(const PocketbaseRecordId *ids, size_t count, uint16_t low, uint16_t high,
+                                         uint8_t ranges, const char *filter, PocketbaseReconcileCallback callback,
+                                         void *context, PocketbaseReconcileResult &result)
+{
+    if (ranges > high - low)
+    {
+        ranges = high - low;
+    }
+
+    // current_endpoint is "collections/<name>/", the route takes the bare collection name
+    String path = "pbext/digest/";
+    path += current_endpoint.substring(12, current_endpoint.length() - 1);
+    bool hasQuery = false;
+
+    char number[8];
+    snprintf(number, sizeof(number), "%u", (unsigned)ranges);
+    appendQueryParam(path, hasQuery, "ranges", number);
+    snprintf(number, sizeof(number), "%u", (unsigned)low);
+    appendQueryParam(path, hasQuery, "low", number);
+    snprintf(number, sizeof(number), "%u", (unsigned)high);
+    appendQueryParam(path, hasQuery, "high", number);
+    appendQueryParam(path, hasQuery, "filter", filter);
+
+    PocketbaseResponse response = performRequest("GET", path, nullptr);
+    result.requests++;
+    if (!response.ok())
+    {
+        return false;
+    }
+
+    // {"ranges":N,"items":[[count,hash],...]}, one item per range in order
+    const char *c = strstr(response.c_str(), "\"items\"");
+    if (c == nullptr || (c = strchr(c, '[')) == nullptr)
+    {
+        return false;
+    }
+    c++;
+
+    for (uint8_t index = 0; index < ranges; index++)
+    {
+        char *end;
+        c = strchr(c, '[');
+        if (c == nullptr)
+        {
+            return false;
+        }
+        uint32_t serverCount = strtoul(c + 1, &end, 10);
+        if (*end != ',')
+        {
+            return false;
+        }
+        uint32_t serverHash = strtoul(end + 1, &end, 10);
+        c = end;
+
+        uint32_t start = rangeStart(low, high, ranges, index);
+        uint32_t stop = rangeStart(low, high, ranges, index + 1);
+        size_t first = lowerBound(ids, count, start);
+        size_t localCount = lowerBound(ids, count, stop) - first;
+
+        uint32_t localHash = 0;
+        for (size_t i = first; i < first + localCount; i++)
+        {
+            localHash ^= idHash(ids[i]);
+        }
+        result.rangesCompared++;
+
+        if (localCount == serverCount && localHash == serverHash)
+        {
+            continue;
+        }
+
+        bool done;
+        if (serverCount == 0)
+        {
+            // Nothing left on the server, no need to ask which ids
+            reportIds(ids + first, localCount, true, callback, context, result);
+            done = true;
+        }
+        else if (serverCount > PB_RECONCILE_LIST_MAX && stop - start > 1)
+        {
+            done = reconcileRanges(ids + first, localCount, start, stop, PB_RECONCILE_RANGES,
+                                   filter, callback, context, result);
+        }
+        else
+        {
+            done = reconcileList(ids + first, localCount, start, stop, filter, callback, context, result);
+        }
+        if (!done)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PocketbaseExtended::reconcileList(const PocketbaseRecordId *ids, size_t count, uint16_t low, uint16_t high,
+                                       const char *filter, PocketbaseReconcileCallback callback, void *context,
+                                       PocketbaseReconcileResult &result)
+{
+    result.rangesListed++;
+
+    char perPage[8];
+    snprintf(perPage, sizeof(perPage), "%u", (unsigned)PB_RECONCILE_LIST_MAX);
+
+    String rangeFilter;
+    if (filter != nullptr && filter[0] != '\0')
+    {
+        rangeFilter += '(';
+        rangeFilter += filter;
+        rangeFilter += ')';
+    }
+    else
+    {
+        rangeFilter += "id != ''";
+    }
+    appendIdBound(rangeFilter, ">=", low);
+    if (high < PB_RECORD_ID_PREFIXES)
+    {
+        appendIdBound(rangeFilter, "<", high);
+    }
+
+    // Ids come sorted, local and server ids are merged as they arrive. Pages follow the last id seen
+    // rather than a page number, so the server does not rescan the skipped records.
+    size_t local = 0;
+    String cursor;
+    while (true)
+    {
+        String pageFilter = rangeFilter;
+        if (cursor.length() > 0)
+        {
+            pageFilter += " && id > '";
+            pageFilter += cursor;
+            pageFilter += '\'';
+        }
+
+        PocketbaseResponse response = getList(nullptr, perPage, "id", pageFilter.c_str(), "1", nullptr, "id");
+        result.requests++;
+        if (!response.ok())
+        {
+            return false;
+        }
+
+        uint16_t listed = 0;
+        for (const char *c = strstr(response.c_str(), "\"id\":\""); c != nullptr; c = strstr(c, "\"id\":\""))
+        {
+            c += 6;
+            const char *end = strchr(c, '"');
+            if (end == nullptr)
+            {
+                return false;
+            }
+            listed++;
+
+            // Ids that cannot be packed cannot be held locally either
+            PocketbaseRecordId id;
+            if (id.parse(c, end - c))
+            {
+                while (local < count && ids[local] < id)
+                {
+                    reportIds(ids + local, 1, true, callback, context, result);
+                    local++;
+                }
+                if (local < count && ids[local] == id)
+                {
+                    local++;
+                }
+                else
+                {
+                    reportIds(&id, 1, false, callback, context, result);
+                }
+            }
+            cursor = "";
+            cursor.concat(c, end - c);
+            c = end;
+        }
+        result.idsListed += listed;
+
+        if (listed < PB_RECONCILE_LIST_MAX)
+        {
+            break;
+        }
+    }
+
+    // Past the last id of the server
+    reportIds(ids + local, count - local, true, callback, context, result);
+    return true;
+}
+
+#endif
@@ -0,0 +1,402 @@
+// PocketbaseRecord.cpp
+
+#include "PocketbaseRecord.h"
+#include "PocketbaseJson.h"
+
+static const char *skipWhitespace(const char *c)
+{
+    while (*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n')
+    {
+        c++;
+    }
+    return c;
+}
+
+// c points at the opening quote, returns past the closing one (nullptr when unterminated)
+static const char *skipString(const char *c)
+{
+    for (c++; *c != '\0'; c++)
+    {
+        if (*c == '\\')
+        {
+            if (*++c == '\0')
+            {
+                return nullptr;
+            }
+        }
+        else if (*c == '"')
+        {
+            return c + 1;
+        }
+    }
+    return nullptr;
+}
+
+// Skips any value, nested objects and arrays included
+static const char *skipValue(const char *c)
+{
+    uint8_t depth = 0;
+    do
+    {
+        c = skipWhitespace(c);
+        if (*c == '"')
+        {
+            c = skipString(c);
+            if (c == nullptr)
+            {
+                return nullptr;
+            }
+        }
+        else if (*c == '{' || *c == '[')
+        {
+            depth++;
+            c++;
+        }
+        else if (*c == '}' || *c == ']')
+        {
+            if (depth == 0)
+            {
+                return nullptr;
+            }
+            depth--;
+            c++;
+        }
+        else if (*c == '\0')
+        {
+            return nullptr;
+        }
+        else
+        {
+            // Number, literal, or a separator inside a nested value
+            c++;
+            while (depth == 0 && *c != '\0' && *c != ',' && *c != '}' && *c != ']' &&
+                   *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n')
+            {
+                c++;
+            }
+        }
+    } while (depth > 0);
+    return c;
+}
+
+static int8_t hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Unescapes the string at c into out. Returns past the closing quote, or nullptr when malformed.
+// fits is cleared when the value is longer than out, which is then left empty.
+static const char *readString(const char *c, char *out, size_t size, bool &fits)
+{
+    size_t length = 0;
+    bool fit = true;
+    for (c++; *c != '"'; c++)
+    {
+        char decoded[3];
+        uint8_t decodedLength = 1;
+        decoded[0] = *c;
+
+        if (*c == '\0')
+        {
+            return nullptr;
+        }
+        if (*c == '\\')
+        {
+            c++;
+            switch (*c)
+            {
+            case 'b':
+                decoded[0] = '\b';
+                break;
+            case 'f':
+                decoded[0] = '\f';
+                break;
+            case 'n':
+                decoded[0] = '\n';
+                break;
+            case 'r':
+                decoded[0] = '\r';
+                break;
+            case 't':
+                decoded[0] = '\t';
+                break;
+            case 'u':
+            {
+                // Basic multilingual plane only, written back as UTF-8
+                uint16_t code = 0;
+                for (uint8_t i = 1; i <= 4; i++)
+                {
+                    int8_t digit = hexValue(c[i]);
+                    if (digit < 0)
+                    {
+                        return nullptr;
+                    }
+                    code = (code << 4) | digit;
+                }
+                c += 4;
+                if (code < 0x80)
+                {
+                    decoded[0] = (char)code;
+                }
+                else if (code < 0x800)
+                {
+                    decoded[0] = (char)(0xC0 | (code >> 6));
+                    decoded[1] = (char)(0x80 | (code & 0x3F));
+                    decodedLength = 2;
+                }
+                else
+                {
+                    decoded[0] = (char)(0xE0 | (code >> 12));
+                    decoded[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+                    decoded[2] = (char)(0x80 | (code & 0x3F));
+                    decodedLength = 3;
+                }
+                break;
+            }
+            case '\0':
+                return nullptr;
+            default:
+                // \" \\ \/
+                decoded[0] = *c;
+                break;
+            }
+        }
+
+        if (length + decodedLength < size)
+        {
+            memcpy(out + length, decoded, decodedLength);
+            length += decodedLength;
+        }
+        else
+        {
+            fit = false;
+        }
+    }
+
+    out[fit ? length : 0] = '\0';
+    fits = fits && fit;
+    return c + 1;
+}
+
+static const PocketbaseField *findField(const PocketbaseField *fields, uint8_t count, const char *key, size_t keyLength)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (strncmp(fields[i].name, key, keyLength) == 0 && fields[i].name[keyLength] == '\0')
+        {
+            return &fields[i];
+        }
+    }
+    return nullptr;
+}
+
+// Parses the value at c into the member described by field, returns past the value
+static const char *readField(const char *c, const PocketbaseField &field, uint8_t *record, bool &fits)
+{
+    uint8_t *member = record + field.offset;
+
+    if (strncmp(c, "null", 4) == 0)
+    {
+        // Already zeroed
+        return c + 4;
+    }
+
+    switch (field.type)
+    {
+    case PB_FIELD_TEXT:
+        if (*c != '"')
+        {
+            return skipValue(c);
+        }
+        return readString(c, (char *)member, field.size, fits);
+
+    case PB_FIELD_INT:
+    {
+        int32_t value;
+        const char *end = pocketbaseParseInt(c, value);
+        if (end == nullptr)
+        {
+            return skipValue(c);
+        }
+        memcpy(member, &value, sizeof(value));
+        return end;
+    }
+
+    case PB_FIELD_FLOAT:
+    {
+        float value;
+        const char *end = pocketbaseParseFloat(c, value);
+        if (end == nullptr)
+        {
+            return skipValue(c);
+        }
+        memcpy(member, &value, sizeof(value));
+        return end;
+    }
+
+    case PB_FIELD_TIMESTAMP:
+    {
+        // Empty dates are "", which leaves the member at 0
+        int64_t value;
+        if (*c == '"' && pocketbaseParseTimestamp(c + 1, value))
+        {
+            memcpy(member, &value, sizeof(value));
+        }
+        return skipValue(c);
+    }
+
+    case PB_FIELD_BOOL:
+        *(bool *)member = strncmp(c, "true", 4) == 0;
+        return skipValue(c);
+
+    case PB_FIELD_RECORD_ID:
+    {
+        // Ids never contain escapes, the characters between the quotes are packed as they are
+        const char *end = *c == '"' ? skipString(c) : nullptr;
+        if (end == nullptr)
+        {
+            return skipValue(c);
+        }
+        PocketbaseRecordId id;
+        if (!id.parse(c + 1, end - c - 2) && end - c > 2)
+        {
+            fits = false;
+        }
+        memcpy(member, &id, sizeof(id));
+        return end;
+    }
+    }
+    return skipValue(c);
+}
+
+bool pocketbaseDecodeRecord(const char *json, const PocketbaseField *fields, uint8_t count, void *record)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint8_t *member = (uint8_t *)record + fields[i].offset;
+        if (fields[i].type == PB_FIELD_RECORD_ID)
+        {
+            // Zeroed words would be the id "000000000000000"
+            PocketbaseRecordId empty;
+            memcpy(member, &empty, sizeof(empty));
+        }
+        else
+        {
+            memset(member, 0, fields[i].size);
+        }
+    }
+
+    const char *c = json != nullptr ? skipWhitespace(json) : nullptr;
+    if (c == nullptr || *c != '{')
+    {
+        return false;
+    }
+
+    bool fits = true;
+    c = skipWhitespace(c + 1);
+    while (*c == '"')
+    {
+        const char *key = c + 1;
+        const char *keyEnd = skipString(c);
+        if (keyEnd == nullptr)
+        {
+            return false;
+        }
+
+        c = skipWhitespace(keyEnd);
+        if (*c != ':')
+        {
+            return false;
+        }
+        c = skipWhitespace(c + 1);
+
+        const PocketbaseField *field = findField(fields, count, key, keyEnd - 1 - key);
+        c = field != nullptr ? readField(c, *field, (uint8_t *)record, fits) : skipValue(c);
+        if (c == nullptr)
+        {
+            return false;
+        }
+
+        c = skipWhitespace(c);
+        if (*c == ',')
+        {
+            c = skipWhitespace(c + 1);
+        }
+    }
+    return *c == '}' && fits;
+}
+
+void pocketbaseEncodeRecord(const void *record, const PocketbaseField *fields, uint8_t count, String &json)
+{
+    const uint8_t *base = (const uint8_t *)record;
+    PocketbaseJsonWriter writer(json);
+
+    writer.beginObject();
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const PocketbaseField &field = fields[i];
+        const uint8_t *member = base + field.offset;
+        if (!field.writable)
+        {
+            continue;
+        }
+
+        writer.key(field.name);
+        switch (field.type)
+        {
+        case PB_FIELD_TEXT:
+            writer.value((const char *)member);
+            break;
+
+        case PB_FIELD_INT:
+        {
+            int32_t value;
+            memcpy(&value, member, sizeof(value));
+            writer.value((long)value);
+            break;
+        }
+
+        case PB_FIELD_FLOAT:
+        {
+            float value;
+            memcpy(&value, member, sizeof(value));
+            writer.value(value);
+            break;
+        }
+
+        case PB_FIELD_BOOL:
+            writer.value(*(const bool *)member);
+            break;
+
+        case PB_FIELD_TIMESTAMP:
+        {
+            int64_t value;
+            memcpy(&value, member, sizeof(value));
+            char timestamp[PB_TIMESTAMP_SIZE] = "";
+            if (value != 0)
+            {
+                pocketbaseFormatTimestamp(value, timestamp);
+            }
+            writer.value(timestamp);
+            break;
+        }
+
+        case PB_FIELD_RECORD_ID:
+        {
+            PocketbaseRecordId value;
+            memcpy(&value, member, sizeof(value));
+            char id[PB_RECORD_ID_SIZE];
+            value.format(id);
+            writer.value(id);
+            break;
+        }
+        }
+    }
+    writer.endObject();
+}
@@ -0,0 +1,68 @@
+// PocketbaseRecord.h
+
+#ifndef PocketbaseRecord_h
+#define PocketbaseRecord_h
+
+#include "Arduino.h"
+#include "PocketbaseRecordId.h"
+#include "PocketbaseTime.h"
+
+/*
+    Typed records, decoded from and encoded to JSON through a table describing the fields of a C++ struct.
+    The structs and their tables are generated from the collections export of the server by
+    tools/pocketbase_codegen.py, see the README.
+*/
+
+enum PocketbaseFieldType : uint8_t
+{
+    PB_FIELD_TEXT,      // char[size], NUL terminated: text, email, url, editor, single select/file, ids not in [a-z0-9]{15}
+    PB_FIELD_INT,       // int32_t: number with "onlyInt"
+    PB_FIELD_FLOAT,     // float: number
+    PB_FIELD_BOOL,      // bool
+    PB_FIELD_TIMESTAMP, // int64_t milliseconds since the epoch, 0 when empty: date, autodate
+    PB_FIELD_RECORD_ID, // PocketbaseRecordId, empty when "": id, single relation
+};
+
+/**
+ * @brief   Describes one field of a record struct.
+ */
+struct PocketbaseField
+{
+    const char *name;         // Field name in the collection
+    PocketbaseFieldType type;
+    bool writable;            // False for fields set by the server (id, autodate), left out of encoded records
+    uint16_t offset;          // offsetof() the member in the record struct
+    uint16_t size;            // sizeof() the member
+};
+
+/**
+ * @brief           Fills a record struct from a JSON record (ex.: the body of getOne()). Fields absent from the JSON
+ *                  are zeroed (record ids are left empty), unknown keys are skipped.
+ *
+ * @param json      The JSON object.
+ *
+ * @param fields    The field table of the record struct.
+ *
+ * @param count     Number of entries in fields.
+ *
+ * @param record    The record struct to fill.
+ *
+ * @return          False when json is not an object, or when a text value does not fit its member or an id
+ *                  cannot be packed (the member is left empty).
+ */
+bool pocketbaseDecodeRecord(const char *json, const PocketbaseField *fields, uint8_t count, void *record);
+
+/**
+ * @brief           Appends the writable fields of a record struct to json as a JSON object, ex. the body of create().
+ *
+ * @param record    The record struct.
+ *
+ * @param fields    The field table of the record struct.
+ *
+ * @param count     Number of entries in fields.
+ *
+ * @param json      The string the object is appended to.
+ */
+void pocketbaseEncodeRecord(const void *record, const PocketbaseField *fields, uint8_t count, String &json);
+
+#endif
@@ -0,0 +1,150 @@
+// PocketbaseRecordId.cpp
+
+#include "PocketbaseRecordId.h"
+
+// words[0] of an empty id, above the largest 3 digits value (46655)
+#define PB_RECORD_ID_EMPTY 0xFFFF
+
+static const char digits36[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+static int8_t digitValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 10;
+    return -1;
+}
+
+// Reads count base 36 digits, returns false on a character outside of [a-z0-9]
+static bool readDigits(const char *text, uint8_t count, uint32_t &value)
+{
+    value = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        int8_t digit = digitValue(text[i]);
+        if (digit < 0)
+        {
+            return false;
+        }
+        value = value * 36 + digit;
+    }
+    return true;
+}
+
+// Writes value as count base 36 digits ending at end
+static void writeDigits(char *end, uint8_t count, uint32_t value)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        *--end = digits36[value % 36];
+        value /= 36;
+    }
+}
+
+PocketbaseRecordId::PocketbaseRecordId()
+{
+    words[0] = PB_RECORD_ID_EMPTY;
+    words[1] = words[2] = words[3] = words[4] = 0;
+}
+
+PocketbaseRecordId::PocketbaseRecordId(const char *text) : PocketbaseRecordId()
+{
+    if (text != nullptr)
+    {
+        parse(text, strlen(text));
+    }
+}
+
+bool PocketbaseRecordId::parse(const char *text, size_t length)
+{
+    uint32_t head, middle, tail;
+    if (length != PB_RECORD_ID_LENGTH ||
+        !readDigits(text, 3, head) || !readDigits(text + 3, 6, middle) || !readDigits(text + 9, 6, tail))
+    {
+        *this = PocketbaseRecordId();
+        return false;
+    }
+
+    words[0] = (uint16_t)head;
+    words[1] = (uint16_t)(middle >> 16);
+    words[2] = (uint16_t)middle;
+    words[3] = (uint16_t)(tail >> 16);
+    words[4] = (uint16_t)tail;
+    return true;
+}
+
+bool PocketbaseRecordId::isEmpty() const
+{
+    return words[0] == PB_RECORD_ID_EMPTY;
+}
+
+void PocketbaseRecordId::format(char *text) const
+{
+    if (isEmpty())
+    {
+        text[0] = '\0';
+        return;
+    }
+
+    writeDigits(text + 3, 3, words[0]);
+    writeDigits(text + 9, 6, ((uint32_t)words[1] << 16) | words[2]);
+    writeDigits(text + 15, 6, ((uint32_t)words[3] << 16) | words[4]);
+    text[PB_RECORD_ID_LENGTH] = '\0';
+}
+
+String PocketbaseRecordId::toString() const
+{
+    char text[PB_RECORD_ID_SIZE];
+    format(text);
+    return String(text);
+}
+
+uint32_t PocketbaseRecordId::hash() const
+{
+    uint32_t middle = ((uint32_t)words[1] << 16) | words[2];
+    uint32_t tail = ((uint32_t)words[3] << 16) | words[4];
+    return tail ^ (middle * 0x9E3779B1UL) ^ words[0];
+}
+
+uint16_t PocketbaseRecordId::prefix() const
+{
+    return words[0];
+}
+
+bool PocketbaseRecordId::operator==(const PocketbaseRecordId &other) const
+{
+    return memcmp(words, other.words, sizeof(words)) == 0;
+}
+
+bool PocketbaseRecordId::operator!=(const PocketbaseRecordId &other) const
+{
+    return !(*this == other);
+}
+
+bool PocketbaseRecordId::operator<(const PocketbaseRecordId &other) const
+{
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        if (words[i] != other.words[i])
+        {
+            return words[i] < other.words[i];
+        }
+    }
+    return false;
+}
+
+bool PocketbaseRecordId::operator>(const PocketbaseRecordId &other) const
+{
+    return other < *this;
+}
+
+bool PocketbaseRecordId::operator<=(const PocketbaseRecordId &other) const
+{
+    return !(other < *this);
+}
+
+bool PocketbaseRecordId::operator>=(const PocketbaseRecordId &other) const
+{
+    return !(*this < other);
+}
@@ -0,0 +1,71 @@
+// PocketbaseRecordId.h
+
+#ifndef PocketbaseRecordId_h
+#define PocketbaseRecordId_h
+
+#include "Arduino.h"
+
+// Length of a PocketBase record id ([a-z0-9]{15})
+#define PB_RECORD_ID_LENGTH 15
+// Size of a record id formatted with its terminating NUL
+#define PB_RECORD_ID_SIZE (PB_RECORD_ID_LENGTH + 1)
+// Number of distinct values of prefix(), 36^3
+#define PB_RECORD_ID_PREFIXES 46656
+
+/**
+ * @brief   A record id packed in 10 bytes instead of a String (heap block plus its header) or a char[16], for ids kept
+ *          in caches, queues and typed records. The 15 characters are read as base 36 digits: the first 3 in a 16-bit
+ *          word, then two groups of 6 in 32 bits each (36^6 < 2^32, so formatting needs no 64-bit division). Groups
+ *          are stored most significant first and compared in that order, so ids sort the same way as their text.
+ *
+ *          Only the default [a-z0-9]{15} ids can be packed, a collection configured with another id pattern has to
+ *          keep them as text.
+ *
+ *          PocketbaseRecordId id("a1b2c3d4e5f6g7h");
+ *          pb.collection("readings").getOne(id, nullptr, nullptr);
+ */
+class PocketbaseRecordId
+{
+public:
+    // An empty id, see isEmpty()
+    PocketbaseRecordId();
+
+    // Parses text, the id is left empty when it is not 15 characters of [a-z0-9]
+    explicit PocketbaseRecordId(const char *text);
+
+    /**
+     * @brief           Parses the id in the first length characters of text (ex.: straight out of a JSON response).
+     *
+     * @return          False when they are not 15 characters of [a-z0-9], the id is then left empty.
+     */
+    bool parse(const char *text, size_t length);
+
+    // True for a default constructed id or one that failed to parse
+    bool isEmpty() const;
+
+    // Writes the 15 characters and a NUL into text, which must hold PB_RECORD_ID_SIZE characters. Empty ids are written as "".
+    void format(char *text) const;
+    String toString() const;
+
+    // The low digits of an id are random, they make a uniform hash for tables indexed by id
+    uint32_t hash() const;
+
+    // The first 3 characters as a base 36 number (0 to PB_RECORD_ID_PREFIXES - 1), ids sort by it first.
+    // Used to split the id space in ranges, see PocketbaseExtended::reconcile().
+    uint16_t prefix() const;
+
+    bool operator==(const PocketbaseRecordId &other) const;
+    bool operator!=(const PocketbaseRecordId &other) const;
+    bool operator<(const PocketbaseRecordId &other) const;
+    bool operator>(const PocketbaseRecordId &other) const;
+    bool operator<=(const PocketbaseRecordId &other) const;
+    bool operator>=(const PocketbaseRecordId &other) const;
+
+private:
+    // words[0] holds the first 3 digits (up to 36^3 - 1, 0xFFFF when empty), words[1..2] and words[3..4] the
+    // next groups of 6, high word first. 16-bit words keep the alignment at 2, so the id takes 10 bytes in
+    // arrays and structs without being packed.
+    uint16_t words[5];
+};
+
+#endif
@@ -0,0 +1,70 @@
+// PocketbaseResponse.cpp
+
+#include "PocketbaseExtended.h"
+
+PocketbaseResponse::PocketbaseResponse() : status_code(0)
+{
+}
+
+PocketbaseResponse::PocketbaseResponse(int statusCode, String &&body)
+    : status_code(statusCode), response_body(std::move(body))
+{
+}
+
+PocketbaseResponse::PocketbaseResponse(PocketbaseResponse &&other)
+    : status_code(other.status_code), response_body(std::move(other.response_body))
+{
+    other.status_code = 0;
+}
+
+PocketbaseResponse &PocketbaseResponse::operator=(PocketbaseResponse &&other)
+{
+    if (this != &other)
+    {
+        status_code = other.status_code;
+        response_body = std::move(other.response_body);
+        other.status_code = 0;
+    }
+    return *this;
+}
+
+int PocketbaseResponse::statusCode() const
+{
+    return status_code;
+}
+
+bool PocketbaseResponse::ok() const
+{
+    return status_code >= 200 && status_code < 300;
+}
+
+const char *PocketbaseResponse::c_str() const
+{
+    return response_body.c_str();
+}
+
+size_t PocketbaseResponse::length() const
+{
+    return response_body.length();
+}
+
+bool PocketbaseResponse::isEmpty() const
+{
+    return response_body.length() == 0;
+}
+
+const String &PocketbaseResponse::body() const
+{
+    return response_body;
+}
+
+String PocketbaseResponse::release()
+{
+    status_code = 0;
+    return std::move(response_body);
+}
+
+size_t PocketbaseResponse::printTo(Print &out) const
+{
+    return out.write((const uint8_t *)response_body.c_str(), response_body.length());
+}
@@ -0,0 +1,119 @@
+// PocketbaseStats.cpp
+
+#include "PocketbaseExtended.h"
+
+#if PB_ENABLE_STATS
+
+void PocketbaseExtended::sampleHeap()
+{
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < request_stats.minFreeHeap)
+    {
+        request_stats.minFreeHeap = freeHeap;
+    }
+}
+
+void PocketbaseExtended::recordRequest(uint32_t startedAt, size_t sent, size_t received, bool failed)
+{
+    uint32_t elapsed = millis() - startedAt;
+
+    request_stats.requests++;
+    if (failed)
+    {
+        request_stats.failures++;
+    }
+    request_stats.bytesSent += sent;
+    request_stats.bytesReceived += received;
+    request_stats.lastLatencyMs = elapsed;
+    request_stats.totalLatencyMs += elapsed;
+    // The connection is opened and closed around every request, so the radio stays busy for its whole duration
+    request_stats.radioOnMs += elapsed;
+
+    uint8_t bucket = 0;
+    while (bucket < PB_LATENCY_BUCKETS - 1 && (elapsed >> (bucket + 1)) != 0)
+    {
+        bucket++;
+    }
+    if (request_stats.latencyBuckets[bucket] < UINT16_MAX)
+    {
+        request_stats.latencyBuckets[bucket]++;
+    }
+}
+
+const PocketbaseStats &PocketbaseExtended::stats() const
+{
+    return request_stats;
+}
+
+void PocketbaseExtended::resetStats()
+{
+    memset(&request_stats, 0, sizeof(request_stats));
+    request_stats.minFreeHeap = UINT32_MAX;
+}
+
+uint32_t PocketbaseExtended::latencyPercentile(uint8_t percentile) const
+{
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < PB_LATENCY_BUCKETS; i++)
+    {
+        total += request_stats.latencyBuckets[i];
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    uint32_t rank = (total * percentile + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < PB_LATENCY_BUCKETS; i++)
+    {
+        uint32_t count = request_stats.latencyBuckets[i];
+        if (seen + count >= rank)
+        {
+            // Bucket i holds latencies in [2^i, 2^(i+1)) ms (0 and 1 ms for bucket 0), taken as evenly spread
+            uint32_t low = i == 0 ? 0 : 1UL << i;
+            uint32_t high = (1UL << (i + 1)) - 1;
+            return low + (uint32_t)((uint64_t)(high - low) * (rank - seen) / count);
+        }
+        seen += count;
+    }
+    return (1UL << PB_LATENCY_BUCKETS) - 1;
+}
+
+void PocketbaseExtended::printStats(Print &out) const
+{
+    uint32_t avg = request_stats.requests > 0 ? request_stats.totalLatencyMs / request_stats.requests : 0;
+
+    out.printf("[PB] requests=%u failures=%u sent=%u recv=%u avg=%ums p50~%ums p95~%ums p99~%ums radio=%ums minHeap=%u\n",
+               (unsigned)request_stats.requests, (unsigned)request_stats.failures,
+               (unsigned)request_stats.bytesSent, (unsigned)request_stats.bytesReceived,
+               (unsigned)avg, (unsigned)latencyPercentile(50), (unsigned)latencyPercentile(95),
+               (unsigned)latencyPercentile(99), (unsigned)request_stats.radioOnMs,
+               (unsigned)(request_stats.requests > 0 ? request_stats.minFreeHeap : 0));
+#if PB_ENABLE_THROTTLE
+    out.printf("[PB] throttled=%u rateLimited=%u\n",
+               (unsigned)request_stats.throttled, (unsigned)request_stats.rateLimited);
+
+    uint32_t now = millis();
+#endif
+    for (uint8_t i = 0; i < server_count; i++)
+    {
+        const PocketbaseServer &server = servers[i];
+#if PB_ENABLE_THROTTLE
+        uint32_t blockedMs = server.blocked && (int32_t)(server.blockedUntil - now) > 0 ? server.blockedUntil - now : 0;
+
+        out.printf("[PB] endpoint %s:%u %s ewma=%ums rate=%u.%03ureq/s blocked=%ums %s\n",
+                   server.host.c_str(), (unsigned)server.port,
+                   server.role == PB_ROLE_PRIMARY ? "primary" : "replica", (unsigned)server.latencyEwmaMs,
+                   (unsigned)(server.rateMilli / 1000), (unsigned)(server.rateMilli % 1000),
+                   (unsigned)blockedMs, server.healthy ? "healthy" : "unhealthy");
+#else
+        out.printf("[PB] endpoint %s:%u %s ewma=%ums %s\n",
+                   server.host.c_str(), (unsigned)server.port,
+                   server.role == PB_ROLE_PRIMARY ? "primary" : "replica", (unsigned)server.latencyEwmaMs,
+                   server.healthy ? "healthy" : "unhealthy");
+#endif
+    }
+}
+
+#endif
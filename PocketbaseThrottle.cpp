@@ -0,0 +1,122 @@
+// PocketbaseThrottle.cpp
+
+#include "PocketbaseExtended.h"
+#include "PocketbaseTime.h"
+
+#if PB_ENABLE_THROTTLE
+
+void PocketbaseExtended::setRateLimit(float maxPerSecond, uint8_t burst)
+{
+    rate_max_milli = maxPerSecond > 0 ? (uint32_t)(maxPerSecond * 1000) : PB_RATE_MAX_MILLI;
+    rate_burst = burst > 0 ? burst : 1;
+
+    for (uint8_t i = 0; i < server_count; i++)
+    {
+        if (servers[i].rateMilli > rate_max_milli)
+        {
+            servers[i].rateMilli = rate_max_milli;
+        }
+    }
+}
+
+bool PocketbaseExtended::acquireRequestSlot(PocketbaseServer &server)
+{
+    uint32_t now = millis();
+
+    if (server.blocked)
+    {
+        if ((int32_t)(now - server.blockedUntil) < 0)
+        {
+            return false;
+        }
+        server.blocked = false;
+    }
+
+    uint32_t capacity = (uint32_t)rate_burst * 1000;
+    uint64_t tokens = server.tokensMilli + (uint64_t)(now - server.refilledAt) * server.rateMilli / 1000;
+    server.tokensMilli = tokens > capacity ? capacity : (uint32_t)tokens;
+    server.refilledAt = now;
+
+    if (server.tokensMilli < 1000)
+    {
+        return false;
+    }
+    server.tokensMilli -= 1000;
+    return true;
+}
+
+void PocketbaseExtended::adaptRequestRate(PocketbaseServer &server, int httpCode)
+{
+    if (httpCode <= 0)
+    {
+        // No answer tells nothing about the server load, failover handles it
+        return;
+    }
+
+    if (httpCode != 429 && httpCode != 503)
+    {
+        // Additive increase
+        server.rateMilli += PB_RATE_INCREASE_MILLI;
+        if (server.rateMilli > rate_max_milli)
+        {
+            server.rateMilli = rate_max_milli;
+        }
+        return;
+    }
+
+    // Multiplicative decrease, and start from an empty bucket so the next request waits a full interval
+#if PB_ENABLE_STATS
+    request_stats.rateLimited++;
+#endif
+    server.rateMilli /= 2;
+    if (server.rateMilli < PB_RATE_MIN_MILLI)
+    {
+        server.rateMilli = PB_RATE_MIN_MILLI;
+    }
+    server.tokensMilli = 0;
+
+    uint32_t delayMs = retryAfterMs(response_headers.retryAfter);
+    if (delayMs > 0)
+    {
+        server.blocked = true;
+        server.blockedUntil = millis() + delayMs;
+    }
+
+    PB_LOG("[PB] %s answered %d, rate lowered to %u.%03ureq/s, retry after %ums\n",
+           server.host.c_str(), httpCode, (unsigned)(server.rateMilli / 1000),
+           (unsigned)(server.rateMilli % 1000), (unsigned)delayMs);
+}
+
+uint32_t PocketbaseExtended::retryAfterMs(const char *retryAfter) const
+{
+    if (retryAfter == nullptr || retryAfter[0] == '\0')
+    {
+        return 0;
+    }
+
+    // Retry-After is either a number of seconds or an HTTP date
+    uint64_t delayMs;
+    if (retryAfter[0] >= '0' && retryAfter[0] <= '9')
+    {
+        delayMs = strtoul(retryAfter, nullptr, 10) * 1000ULL;
+    }
+    else
+    {
+#if PB_ENABLE_SERVER_CLOCK
+        int64_t retryAt;
+        if (!clock_synced || !pocketbaseParseHttpDate(retryAfter, retryAt))
+        {
+            return 0;
+        }
+        int64_t remaining = retryAt - serverTimeMs();
+        delayMs = remaining > 0 ? (uint64_t)remaining : 0;
+#else
+        // Dates can only be compared with the server clock
+        return 0;
+#endif
+    }
+
+    return delayMs > PB_RETRY_AFTER_MAX_MS ? PB_RETRY_AFTER_MAX_MS : (uint32_t)delayMs;
+}
+
+#endif
@@ -0,0 +1,212 @@
+// PocketbaseTime.cpp
+
+#include "PocketbaseTime.h"
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's days_from_civil)
+int32_t pocketbaseDaysFromCivil(int32_t year, uint32_t month, uint32_t day)
+{
+    year -= month <= 2;
+    int32_t era = (year >= 0 ? year : year - 399) / 400;
+    uint32_t yearOfEra = (uint32_t)(year - era * 400);
+    uint32_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + (int32_t)dayOfEra - 719468;
+}
+
+void pocketbaseCivilFromDays(int32_t days, int32_t &year, uint32_t &month, uint32_t &day)
+{
+    days += 719468;
+    int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    uint32_t dayOfEra = (uint32_t)(days - era * 146097);
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t monthPart = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthPart + 2) / 5 + 1;
+    month = monthPart < 10 ? monthPart + 3 : monthPart - 9;
+    year = (int32_t)yearOfEra + era * 400 + (month <= 2);
+}
+
+uint8_t pocketbaseDaysInMonth(int32_t year, uint32_t month)
+{
+    static const uint8_t lengths[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    return month == 2 && leap ? 29 : lengths[month - 1];
+}
+
+// Layout of a PocketBase date: each letter is a digit accumulated into that component, anything
+// else a separator that must match (the date/time one may also be a "T")
+static const char timestampLayout[] = "yyyy-MM-dd HH:mm:ss.SSSZ";
+
+bool pocketbaseParseTimestamp(const char *text, int64_t &epochMs)
+{
+    if (text == nullptr)
+    {
+        return false;
+    }
+
+    // year, month, day, hour, minute, second, millisecond
+    uint32_t parts[7] = {0, 0, 0, 0, 0, 0, 0};
+    for (uint8_t i = 0; timestampLayout[i] != '\0'; i++)
+    {
+        char expected = timestampLayout[i];
+        char c = text[i];
+
+        int8_t part = -1;
+        switch (expected)
+        {
+        case 'y':
+            part = 0;
+            break;
+        case 'M':
+            part = 1;
+            break;
+        case 'd':
+            part = 2;
+            break;
+        case 'H':
+            part = 3;
+            break;
+        case 'm':
+            part = 4;
+            break;
+        case 's':
+            part = 5;
+            break;
+        case 'S':
+            part = 6;
+            break;
+        }
+
+        if (part >= 0)
+        {
+            if (c < '0' || c > '9')
+            {
+                return false;
+            }
+            parts[part] = parts[part] * 10 + (c - '0');
+        }
+        else if (i == 19 && (c == 'Z' || c == '\0'))
+        {
+            // No milliseconds
+            break;
+        }
+        else if (c != expected && !(i == 10 && c == 'T'))
+        {
+            return false;
+        }
+    }
+
+    if (parts[1] < 1 || parts[1] > 12 || parts[2] < 1 || parts[2] > pocketbaseDaysInMonth((int32_t)parts[0], parts[1]) ||
+        parts[3] > 23 || parts[4] > 59 || parts[5] > 59)
+    {
+        return false;
+    }
+
+    int64_t days = pocketbaseDaysFromCivil((int32_t)parts[0], parts[1], parts[2]);
+    epochMs = ((days * 24 + parts[3]) * 60 + parts[4]) * 60000LL + parts[5] * 1000LL + parts[6];
+    return true;
+}
+
+static bool parseDigits(const char *&c, uint8_t count, uint32_t &value)
+{
+    value = 0;
+    for (uint8_t i = 0; i < count; i++, c++)
+    {
+        if (*c < '0' || *c > '9')
+        {
+            return false;
+        }
+        value = value * 10 + (*c - '0');
+    }
+    return true;
+}
+
+// Parses an IMF-fixdate (RFC 7231), the only format servers may generate: "Sun, 06 Nov 1994 08:49:37 GMT"
+bool pocketbaseParseHttpDate(const char *date, int64_t &epochMs)
+{
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+    if (date == nullptr || strlen(date) < 29 || date[3] != ',')
+    {
+        return false;
+    }
+
+    const char *c = date + 5;
+    uint32_t day, year, hour, minute, second;
+    if (!parseDigits(c, 2, day) || *c++ != ' ')
+    {
+        return false;
+    }
+
+    uint32_t month = 0;
+    while (month < 12 && strncmp(months + month * 3, c, 3) != 0)
+    {
+        month++;
+    }
+    if (month == 12)
+    {
+        return false;
+    }
+    c += 4;
+
+    if (!parseDigits(c, 4, year) || *c++ != ' ' ||
+        !parseDigits(c, 2, hour) || *c++ != ':' ||
+        !parseDigits(c, 2, minute) || *c++ != ':' ||
+        !parseDigits(c, 2, second))
+    {
+        return false;
+    }
+    // Second 60 is a leap second, which the fixdate grammar allows
+    if (day < 1 || day > pocketbaseDaysInMonth((int32_t)year, month + 1) || hour > 23 || minute > 59 || second > 60)
+    {
+        return false;
+    }
+
+    int64_t days = pocketbaseDaysFromCivil((int32_t)year, month + 1, day);
+    epochMs = ((days * 24 + hour) * 60 + minute) * 60000LL + second * 1000LL;
+    return true;
+}
+
+// Writes value as width zero padded digits
+static char *writeDigits(char *c, uint32_t value, uint8_t width)
+{
+    for (uint8_t i = width; i > 0; i--)
+    {
+        c[i - 1] = (char)('0' + value % 10);
+        value /= 10;
+    }
+    return c + width;
+}
+
+void pocketbaseFormatTimestamp(int64_t epochMs, char *timestamp)
+{
+    // Floor division, so dates before 1970 still get a positive time of day
+    int32_t days = (int32_t)(epochMs / 86400000LL);
+    int64_t msOfDay = epochMs % 86400000LL;
+    if (msOfDay < 0)
+    {
+        days--;
+        msOfDay += 86400000LL;
+    }
+
+    int32_t year;
+    uint32_t month, day;
+    pocketbaseCivilFromDays(days, year, month, day);
+
+    uint32_t ms = (uint32_t)msOfDay;
+    char *c = writeDigits(timestamp, (uint32_t)year, 4);
+    *c++ = '-';
+    c = writeDigits(c, month, 2);
+    *c++ = '-';
+    c = writeDigits(c, day, 2);
+    *c++ = ' ';
+    c = writeDigits(c, ms / 3600000, 2);
+    *c++ = ':';
+    c = writeDigits(c, ms / 60000 % 60, 2);
+    *c++ = ':';
+    c = writeDigits(c, ms / 1000 % 60, 2);
+    *c++ = '.';
+    c = writeDigits(c, ms % 1000, 3);
+    *c++ = 'Z';
+    *c = '\0';
+}
@@ -0,0 +1,40 @@
+// PocketbaseTime.h
+
+#ifndef PocketbaseTime_h
+#define PocketbaseTime_h
+
+#include "Arduino.h"
+
+// Size of a PocketBase timestamp with its terminating NUL, "2024-01-20 12:00:00.000Z"
+#define PB_TIMESTAMP_SIZE 25
+
+// Days since 1970-01-01 of a proleptic Gregorian date, and back
+int32_t pocketbaseDaysFromCivil(int32_t year, uint32_t month, uint32_t day);
+void pocketbaseCivilFromDays(int32_t days, int32_t &year, uint32_t &month, uint32_t &day);
+// Length of a month (1..12) of a proleptic Gregorian year, leap years included
+uint8_t pocketbaseDaysInMonth(int32_t year, uint32_t month);
+
+/**
+ * @brief           Parses a PocketBase date ("2024-01-20 12:00:00.123Z", "T" separator and missing
+ *                  milliseconds accepted) into milliseconds since the epoch, without allocating.
+ *
+ * @return          False when text is not such a date or names a day the month does not have (ex. 2023-02-29),
+ *                  epochMs is then left untouched.
+ */
+bool pocketbaseParseTimestamp(const char *text, int64_t &epochMs);
+
+/**
+ * @brief           Formats milliseconds since the epoch as a PocketBase date into timestamp, which must hold
+ *                  PB_TIMESTAMP_SIZE characters.
+ */
+void pocketbaseFormatTimestamp(int64_t epochMs, char *timestamp);
+
+/**
+ * @brief           Parses an HTTP date in the IMF-fixdate format servers send ("Sun, 06 Nov 1994 08:49:37 GMT")
+ *                  into milliseconds since the epoch.
+ *
+ * @return          False when date is not such a date, epochMs is then left untouched.
+ */
+bool pocketbaseParseHttpDate(const char *date, int64_t &epochMs);
+
+#endif
@@ -0,0 +1,357 @@
+// PocketbaseTransport.cpp
+
+#include "PocketbaseExtended.h"
+
+#if PB_ENABLE_COALESCED_WRITES
+// How long a request waits for the server when no timeout-retry delay applies, same as HTTPClient
+#define PB_TRANSPORT_TIMEOUT_MS 5000
+// Longest status or header line kept, longer ones are truncated (only their start is looked at)
+#define PB_TRANSPORT_LINE_MAX 128
+
+// Reads a line without its CRLF. Returns the line length, HTTPC_ERROR_READ_TIMEOUT when the server
+// went quiet, or HTTPC_ERROR_CONNECTION_LOST when it closed the connection.
+static int readLine(Client &client, char *line, size_t size, uint32_t timeoutMs)
+{
+    size_t length = 0;
+    uint32_t lastActivity = millis();
+    while (millis() - lastActivity < timeoutMs)
+    {
+        int c = client.read();
+        if (c < 0)
+        {
+            if (!client.connected() && client.available() == 0)
+            {
+                return HTTPC_ERROR_CONNECTION_LOST;
+            }
+            delay(1);
+            continue;
+        }
+        lastActivity = millis();
+
+        if (c == '\n')
+        {
+            if (length > 0 && line[length - 1] == '\r')
+            {
+                length--;
+            }
+            line[length] = '\0';
+            return (int)length;
+        }
+        if (length < size - 1)
+        {
+            line[length++] = (char)c;
+        }
+    }
+    return HTTPC_ERROR_READ_TIMEOUT;
+}
+
+// Appends up to length bytes of body to payload, or everything until the server closes with SIZE_MAX
+static int readBody(Client &client, String &payload, size_t length, uint32_t timeoutMs)
+{
+    char buffer[129];
+    uint32_t lastActivity = millis();
+    while (length > 0)
+    {
+        int available = client.available();
+        if (available <= 0)
+        {
+            if (!client.connected())
+            {
+                return length == SIZE_MAX ? 0 : HTTPC_ERROR_CONNECTION_LOST;
+            }
+            if (millis() - lastActivity >= timeoutMs)
+            {
+                return HTTPC_ERROR_READ_TIMEOUT;
+            }
+            delay(1);
+            continue;
+        }
+
+        size_t wanted = sizeof(buffer) - 1;
+        wanted = wanted < (size_t)available ? wanted : (size_t)available;
+        wanted = wanted < length ? wanted : length;
+        int read = client.read((uint8_t *)buffer, wanted);
+        if (read <= 0)
+        {
+            continue;
+        }
+        buffer[read] = '\0';
+        payload += buffer;
+        if (length != SIZE_MAX)
+        {
+            length -= read;
+        }
+        lastActivity = millis();
+    }
+    return 0;
+}
+
+// Writes data in slices of PB_TLS_RECORD_SIZE: the transmit buffer holds a slice and its record overhead, so
+// each write is sealed as one TLS record, which fits in one TCP segment
+static bool writeRecords(Client &client, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        size_t slice = length < PB_TLS_RECORD_SIZE ? length : PB_TLS_RECORD_SIZE;
+        if (client.write((const uint8_t *)data, slice) != slice)
+        {
+            return false;
+        }
+        data += slice;
+        length -= slice;
+    }
+    return true;
+}
+#endif
+
+#if PB_ENABLE_TLS_PROFILES
+#if defined(ESP8266)
+// Suites of each PocketbaseTlsProfile, ChaCha20 first: without AES hardware it is cheaper than AES-GCM
+static const uint16_t ecdsaAeadSuites[] = {
+    BR_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+    BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+};
+static const uint16_t rsaAeadSuites[] = {
+    BR_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+    BR_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+};
+static const uint16_t ecdheAeadSuites[] = {
+    BR_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+    BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    BR_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+    BR_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+};
+#endif
+
+void PocketbaseExtended::setTlsProfile(PocketbaseTlsProfile profile)
+{
+    tls_profile = profile;
+}
+#endif
+
+void PocketbaseExtended::configureSecureClient(PocketbaseSecureClient &client) const
+{
+    client.setInsecure();
+
+#if PB_ENABLE_TLS_PROFILES && defined(ESP8266)
+    switch (tls_profile)
+    {
+    case PB_TLS_ECDSA_AEAD:
+        client.setCiphers(ecdsaAeadSuites, sizeof(ecdsaAeadSuites) / sizeof(ecdsaAeadSuites[0]));
+        break;
+    case PB_TLS_RSA_AEAD:
+        client.setCiphers(rsaAeadSuites, sizeof(rsaAeadSuites) / sizeof(rsaAeadSuites[0]));
+        break;
+    case PB_TLS_ECDHE_AEAD:
+        client.setCiphers(ecdheAeadSuites, sizeof(ecdheAeadSuites) / sizeof(ecdheAeadSuites[0]));
+        break;
+    case PB_TLS_DEFAULT:
+        break;
+    }
+#endif
+}
+
+void PocketbaseExtended::writeRequestHead(String &request, const PocketbaseServer &server, const char *method, const String &path, const String *requestBody) const
+{
+    request += method;
+    request += ' ';
+    request += server.apiUrl.substring(server.originLength);
+    request += path;
+    request += " HTTP/1.1\r\nHost: ";
+    request += server.host;
+    if (server.port != (server.secure ? 443 : 80))
+    {
+        request += ':';
+        request += (unsigned int)server.port;
+    }
+#if PB_ENABLE_AUTH
+    if (auth_token.length() > 0)
+    {
+        request += "\r\nAuthorization: ";
+        request += auth_token;
+    }
+#endif
+    if (requestBody != nullptr)
+    {
+        request += "\r\nContent-Type: application/json\r\nContent-Length: ";
+        request += (unsigned int)requestBody->length();
+    }
+    request += "\r\nConnection: close\r\n\r\n";
+}
+
+#if PB_ENABLE_COALESCED_WRITES
+int PocketbaseExtended::attemptCoalescedRequest(PocketbaseServer &server, const char *method, const String &path, const String &requestBody, String &payload)
+{
+#if PB_ENABLE_LOG
+    const char *tag = server.secure ? "[HTTPS]" : "[HTTP]";
+#endif
+    uint32_t timeoutMs = request_timeout_ms > 0 ? request_timeout_ms : PB_TRANSPORT_TIMEOUT_MS;
+
+    // Request line and headers, followed in the same buffer by as much of the body as fits in the first record
+    String request;
+    request.reserve(PB_TLS_RECORD_SIZE);
+    writeRequestHead(request, server, method, path, &requestBody);
+
+    size_t inlined = 0;
+    if (request.length() < PB_TLS_RECORD_SIZE)
+    {
+        inlined = PB_TLS_RECORD_SIZE - request.length();
+        inlined = inlined < requestBody.length() ? inlined : requestBody.length();
+        request.concat(requestBody.c_str(), inlined);
+    }
+
+    size_t sent = request.length() + requestBody.length() - inlined;
+    memset(&response_headers, 0, sizeof(response_headers));
+    payload = "";
+
+    PB_LOG("%s Full URL: %s%s\n", tag, server.apiUrl.c_str(), path.c_str());
+
+    std::unique_ptr<PocketbaseSecureClient> secureClient;
+    WiFiClient plainClient;
+    WiFiClient *client = &plainClient;
+    if (server.secure)
+    {
+        secureClient.reset(new PocketbaseSecureClient);
+        configureSecureClient(*secureClient);
+#if defined(ESP8266)
+        // The default 512 bytes transmit buffer would split every write into 512 bytes records. The buffer holds
+        // the record header and the suite's overhead too, not only the plaintext.
+        secureClient->setBufferSizes(PB_TLS_RECEIVE_BUFFER_SIZE, PB_TLS_RECORD_SIZE + PB_TLS_RECORD_OVERHEAD);
+#endif
+        client = secureClient.get();
+    }
+    client->setTimeout(PB_CLIENT_TIMEOUT(timeoutMs));
+
+    sampleHeap();
+    uint32_t startedAt = millis();
+
+    if (!client->connect(server.host.c_str(), server.port))
+    {
+        PB_LOG("%s Unable to connect\n", tag);
+        recordRequest(startedAt, sent, 0, true);
+        return HTTPC_ERROR_CONNECTION_FAILED;
+    }
+    // Nagle would hold a trailing body slice until the previous segment is acked. The option is set on
+    // the socket, so only once it is connected.
+    client->setNoDelay(true);
+
+    PB_LOG("%s %s...\n", tag, method);
+    uint32_t sentAt = millis();
+    if (!writeRecords(*client, request.c_str(), request.length()) ||
+        !writeRecords(*client, requestBody.c_str() + inlined, requestBody.length() - inlined))
+    {
+        PB_LOG("%s %s... failed, error: send failed\n", tag, method);
+        client->stop();
+        recordRequest(startedAt, sent, 0, true);
+        return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+    }
+    // The request buffer is no longer needed, give it back before the response is read
+    request = String();
+
+    char line[PB_TRANSPORT_LINE_MAX];
+    int result = readLine(*client, line, sizeof(line), timeoutMs);
+    int httpCode = HTTPC_ERROR_NO_HTTP_SERVER;
+    if (result >= 0 && strncmp(line, "HTTP/1.", 7) == 0 && line[8] == ' ')
+    {
+        httpCode = atoi(line + 9);
+    }
+    else if (result < 0)
+    {
+        httpCode = result;
+    }
+
+    long contentLength = -1;
+    bool chunked = false;
+    while (httpCode > 0 && (result = readLine(*client, line, sizeof(line), timeoutMs)) > 0)
+    {
+        char *value = strchr(line, ':');
+        if (value == nullptr)
+        {
+            continue;
+        }
+        *value++ = '\0';
+        while (*value == ' ')
+        {
+            value++;
+        }
+
+        if (strcasecmp(line, "Content-Length") == 0)
+        {
+            contentLength = atol(value);
+        }
+        else if (strcasecmp(line, "Transfer-Encoding") == 0)
+        {
+            chunked = strstr(value, "chunked") != nullptr;
+        }
+        else
+        {
+            storeResponseHeader(line, value);
+        }
+    }
+    if (httpCode > 0 && result < 0)
+    {
+        httpCode = result;
+    }
+
+    if (httpCode > 0)
+    {
+        updateServerClock(sentAt, millis());
+
+        if (chunked)
+        {
+            // Each chunk is preceded by its size in hex, a zero size chunk ends the body
+            while ((result = readLine(*client, line, sizeof(line), timeoutMs)) >= 0)
+            {
+                size_t chunkSize = strtoul(line, nullptr, 16);
+                if (chunkSize == 0)
+                {
+                    break;
+                }
+                if ((result = readBody(*client, payload, chunkSize, timeoutMs)) < 0 ||
+                    (result = readLine(*client, line, sizeof(line), timeoutMs)) < 0)
+                {
+                    break;
+                }
+            }
+        }
+        else if (contentLength >= 0)
+        {
+            payload.reserve(contentLength);
+            result = readBody(*client, payload, contentLength, timeoutMs);
+        }
+        else
+        {
+            result = readBody(*client, payload, SIZE_MAX, timeoutMs);
+        }
+
+        if (result < 0)
+        {
+            httpCode = result;
+            payload = "";
+        }
+    }
+    client->stop();
+    sampleHeap();
+
+    if (httpCode > 0)
+    {
+        PB_LOG("%s %s... code: %d\n", tag, method, httpCode);
+#if PB_ENABLE_LOG
+        if (response_secret)
+        {
+            Serial.printf("(%u bytes, not logged)\n", (unsigned)payload.length());
+        }
+        else
+        {
+            Serial.println(payload);
+        }
+#endif
+        recordRequest(startedAt, sent, payload.length(), false);
+        return httpCode;
+    }
+
+    PB_LOG("%s %s... failed, error: %s\n", tag, method, HTTPClient::errorToString(httpCode).c_str());
+    recordRequest(startedAt, sent, 0, true);
+    return httpCode;
+}
+#endif
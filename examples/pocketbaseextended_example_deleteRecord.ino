@@ -29,8 +29,8 @@ const char *ssid = "YOUR_SSID";
 const char *password = "YOUR_PASSWORD";
 
 // Initializing the Pocketbase instance
-PocketbaseArduino pb("YOUR_POCKETBASE_BASE_URL");
-String record;
+PocketbaseExtended pb("YOUR_POCKETBASE_BASE_URL");
+PocketbaseResponse record;
 
 void setup()
 {
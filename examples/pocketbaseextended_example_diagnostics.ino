@@ -0,0 +1,59 @@
+/*
+    pocketbaseextended_example_diagnostics.ino
+
+    Example of using the PocketbaseExtended Library for Arduino.
+
+    Measures DNS, TCP, TLS, time to first byte and download throughput
+    against the server and uploads the report to a "diagnostics" collection.
+
+    https://github.com/jeoooo/PocketbaseExtended
+
+*/
+#include <PocketbaseExtended.h>
+
+// ESP8266
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+
+// FOR ESP32
+// #include <HTTPClient.h>
+// #include <WiFi.h>
+// #include <WiFiClientSecure.h>
+
+// HTTPS REQUESTS
+#include <BearSSLHelpers.h>
+
+const char *ssid = "YOUR_SSID";
+const char *password = "YOUR_PASSWORD";
+
+// Initializing the Pocketbase instance
+PocketbaseExtended pb("YOUR_POCKETBASE_BASE_URL");
+
+void setup()
+{
+    Serial.begin(115200);
+    WiFi.begin(ssid, password);
+
+    while (WiFi.status() != WL_CONNECTED)
+    {
+        delay(1000);
+        Serial.println("Connecting to WiFi...");
+    }
+
+    // runDiagnostics("record_id", "perPage") runs against the current collection,
+    // pass nullptr to skip the getOne or getList measurement
+    PocketbaseDiagnostics diagnostics = pb.collection("collection_name").runDiagnostics("record_id", "200");
+    pb.printDiagnostics(diagnostics);
+
+    // Upload the report so slow sites can be classified remotely
+    pb.collection("diagnostics").create(pb.diagnosticsToJson(diagnostics));
+
+    // Full handshake time with each TLS profile, then keep the cheapest one the server accepts
+    pb.printTlsProfiles();
+    pb.setTlsProfile(PB_TLS_ECDSA_AEAD);
+}
+
+void loop()
+{
+    // loop code here
+}
@@ -0,0 +1,99 @@
+/*
+    pocketbaseextended_example_filter.ino
+
+    Example of using the PocketbaseExtended Library for Arduino.
+
+    Reads a sensor every second but only uploads the readings that
+    changed significantly, through a PocketbaseReportFilter. Records of
+    the "readings" collection have temperature and humidity numbers and
+    a "sampled" date, the time the values were read.
+
+    https://github.com/jeoooo/PocketbaseExtended
+
+*/
+#include <PocketbaseExtended.h>
+#include <PocketbaseTime.h>
+
+// ESP8266
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+
+// FOR ESP32
+// #include <HTTPClient.h>
+// #include <WiFi.h>
+// #include <WiFiClientSecure.h>
+
+// HTTPS REQUESTS
+#include <BearSSLHelpers.h>
+
+const char *ssid = "YOUR_SSID";
+const char *password = "YOUR_PASSWORD";
+
+// Initializing the Pocketbase instance
+PocketbaseExtended pb("YOUR_POCKETBASE_BASE_URL");
+
+// Temperature: swinging door within 0.2 degrees. Humidity: 2% deadband, at most one
+// upload every 30 s because of it. Either way, a record at least every 15 minutes.
+const PocketbaseFilterRule rules[] = {
+    {"temperature", 0, 0.2f, 0, 900000},
+    {"humidity", 2.0f, 0, 30000, 900000},
+};
+PocketbaseReportFilter filter(rules, 2);
+
+void upload(const float *values, uint32_t readAt)
+{
+    String body;
+    body.reserve(96);
+    PocketbaseJsonWriter json(body);
+    json.beginObject();
+    filter.write(json, values);
+    if (pb.hasServerTime())
+    {
+        char sampled[PB_TIMESTAMP_SIZE];
+        pocketbaseFormatTimestamp(pb.serverTimeMs() - (millis() - readAt), sampled);
+        json.field("sampled", sampled);
+    }
+    json.endObject();
+
+    pb.collection("readings").create(body);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    WiFi.begin(ssid, password);
+
+    while (WiFi.status() != WL_CONNECTED)
+    {
+        delay(1000);
+        Serial.println("Connecting to WiFi...");
+    }
+}
+
+void loop()
+{
+    // Replace with the actual sensor
+    float values[] = {20.0f + analogRead(A0) / 100.0f, 45.0f};
+    uint32_t readAt = millis();
+
+    switch (filter.offer("room", values, readAt))
+    {
+    case PB_REPORT_CURRENT:
+        upload(values, readAt);
+        break;
+    case PB_REPORT_PREVIOUS:
+        // The last reading before the trend changed, read one period earlier
+        upload(filter.previous(), filter.previousAt());
+        break;
+    case PB_REPORT_SUPPRESS:
+        break;
+    }
+
+    static uint32_t lastReport = 0;
+    if (millis() - lastReport >= 60000)
+    {
+        lastReport = millis();
+        filter.printStats(); // [PB] filter offered=60 sent=4 suppressed=56 (93%) ...
+    }
+    delay(1000);
+}
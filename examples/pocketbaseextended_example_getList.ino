@@ -29,8 +29,8 @@ const char *ssid = "YOUR_SSID";
 const char *password = "YOUR_PASSWORD";
 
 // Initializing the Pocketbase instance
-PocketbaseArduino pb("YOUR_POCKETBASE_BASE_URL");
-String record;
+PocketbaseExtended pb("YOUR_POCKETBASE_BASE_URL");
+PocketbaseResponse record;
 
 void setup()
 {
@@ -52,6 +52,7 @@ void loop()
 {
     // Fetches and prints data from the 'notes' collection every 5 seconds
     record = pb.collection("collection_name").getList("page", "perPage", "sort", "filter", "skipTotal", "expand", "fields");
-    Serial.println("Data from 'notes' collection:\n" + record);
+    Serial.println("Data from 'notes' collection:");
+    Serial.println(record);
     delay(5000);
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+/*
+    pocketbaseextended_example_json.ino
+
+    Example of using the PocketbaseExtended Library for Arduino.
+
+    Builds a record with PocketbaseJsonWriter and creates it, after comparing
+    the CPU cycles it takes with building the same body through String(float).
+
+    https://github.com/jeoooo/PocketbaseExtended
+
+*/
+#include <PocketbaseExtended.h>
+
+// ESP8266
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+
+// FOR ESP32
+// #include <HTTPClient.h>
+// #include <WiFi.h>
+// #include <WiFiClientSecure.h>
+
+// HTTPS REQUESTS
+#include <BearSSLHelpers.h>
+
+const char *ssid = "YOUR_SSID";
+const char *password = "YOUR_PASSWORD";
+
+// Initializing the Pocketbase instance
+PocketbaseExtended pb("YOUR_POCKETBASE_BASE_URL");
+
+const int runs = 100;
+
+void buildWithString(String &body, float temperature, float humidity, long counter)
+{
+    body = "{\"temperature\":" + String(temperature, 2) +
+           ",\"humidity\":" + String(humidity, 2) +
+           ",\"counter\":" + String(counter) + "}";
+}
+
+void buildWithWriter(String &body, float temperature, float humidity, long counter)
+{
+    body = "";
+    PocketbaseJsonWriter json(body);
+    json.beginObject()
+        .field("temperature", temperature)
+        .field("humidity", humidity)
+        .field("counter", counter)
+        .endObject();
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    WiFi.begin(ssid, password);
+
+    while (WiFi.status() != WL_CONNECTED)
+    {
+        delay(1000);
+        Serial.println("Connecting to WiFi...");
+    }
+
+    String body;
+    body.reserve(96);
+
+    uint32_t startedAt = ESP.getCycleCount();
+    for (int i = 0; i < runs; i++)
+    {
+        buildWithString(body, 21.37f + i, 48.5f, 1000L * i);
+    }
+    uint32_t stringCycles = (ESP.getCycleCount() - startedAt) / runs;
+
+    startedAt = ESP.getCycleCount();
+    for (int i = 0; i < runs; i++)
+    {
+        buildWithWriter(body, 21.37f + i, 48.5f, 1000L * i);
+    }
+    uint32_t writerCycles = (ESP.getCycleCount() - startedAt) / runs;
+
+    Serial.printf("String(float): %u cycles, PocketbaseJsonWriter: %u cycles per body\n",
+                  (unsigned)stringCycles, (unsigned)writerCycles);
+
+    // create() and update() take the body as built
+    Serial.println(pb.collection("collection_name").create(body));
+}
+
+void loop()
+{
+    // loop code here
+}
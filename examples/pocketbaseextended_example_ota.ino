@@ -0,0 +1,64 @@
+/*
+    pocketbaseextended_example_ota.ino
+
+    Example of using the PocketbaseExtended Library for Arduino.
+
+    Checks the "firmware" collection for a release newer than the running
+    one, flashes it and restarts. Release records have a version, a file
+    (the .bin image), its size and its MD5 (see PocketbaseOta.h).
+
+    https://github.com/jeoooo/PocketbaseExtended
+
+*/
+#include <PocketbaseExtended.h>
+
+// ESP8266
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+
+// FOR ESP32
+// #include <HTTPClient.h>
+// #include <WiFi.h>
+// #include <WiFiClientSecure.h>
+
+// HTTPS REQUESTS
+#include <BearSSLHelpers.h>
+
+const char *ssid = "YOUR_SSID";
+const char *password = "YOUR_PASSWORD";
+
+// Version of this build, compared with the version of the latest release
+const char *firmwareVersion = "1.0.0";
+
+// Initializing the Pocketbase instance
+PocketbaseExtended pb("YOUR_POCKETBASE_BASE_URL");
+
+void setup()
+{
+    Serial.begin(115200);
+    WiFi.begin(ssid, password);
+
+    while (WiFi.status() != WL_CONNECTED)
+    {
+        delay(1000);
+        Serial.println("Connecting to WiFi...");
+    }
+
+    Serial.printf("Running version %s\n", firmwareVersion);
+
+    // Only releases built for this board are considered
+    PocketbaseUpdateSink sink;
+    PocketbaseOtaResult result = pb.collection("firmware").updateFirmware(sink, firmwareVersion, "board = 'esp8266'");
+
+    if (result == PB_OTA_UPDATED)
+    {
+        Serial.println("Update installed, restarting");
+        ESP.restart();
+    }
+    Serial.printf("No update installed (result %d)\n", result);
+}
+
+void loop()
+{
+    // loop code here
+}
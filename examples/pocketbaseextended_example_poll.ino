@@ -0,0 +1,74 @@
+/*
+    pocketbaseextended_example_poll.ino
+
+    Example of using the PocketbaseExtended Library for Arduino.
+
+    Downloads a large page of records with beginGetList()/poll() while
+    loop() keeps blinking the built-in LED on time: each poll() call
+    reads at most 2 ms or 1 KB of the response, then returns.
+
+    https://github.com/jeoooo/PocketbaseExtended
+
+*/
+#include <PocketbaseExtended.h>
+
+// ESP8266
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+
+// FOR ESP32
+// #include <HTTPClient.h>
+// #include <WiFi.h>
+// #include <WiFiClientSecure.h>
+
+// HTTPS REQUESTS
+#include <BearSSLHelpers.h>
+
+const char *ssid = "YOUR_SSID";
+const char *password = "YOUR_PASSWORD";
+
+// Initializing the Pocketbase instance
+PocketbaseExtended pb("YOUR_POCKETBASE_BASE_URL");
+
+uint32_t lastBlink = 0;
+uint32_t lastDownload = 0;
+
+void setup()
+{
+    Serial.begin(115200);
+    pinMode(LED_BUILTIN, OUTPUT);
+    WiFi.begin(ssid, password);
+
+    while (WiFi.status() != WL_CONNECTED)
+    {
+        delay(1000);
+        Serial.println("Connecting to WiFi...");
+    }
+
+    // At most 2 ms and 1 KB of the response per poll() call
+    pb.setPollBudget(2000, 1024);
+}
+
+void loop()
+{
+    // The control task that must keep its timing during downloads
+    if (millis() - lastBlink >= 50)
+    {
+        lastBlink = millis();
+        digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN));
+    }
+
+    PocketbasePollStatus status = pb.poll();
+    if (status == PB_POLL_IDLE && millis() - lastDownload >= 30000)
+    {
+        lastDownload = millis();
+        // Same parameters as getList(), if expand or fields are empty place nullptr
+        pb.collection("collection_name").beginGetList("1", "500", "-created", nullptr, "1", nullptr, nullptr);
+    }
+    else if (status == PB_POLL_DONE || status == PB_POLL_FAILED)
+    {
+        PocketbaseResponse response = pb.takeResponse();
+        Serial.printf("Status %d, %u bytes\n", response.statusCode(), (unsigned)response.length());
+        pb.printPollStats();
+    }
+}
@@ -0,0 +1,61 @@
+/// <reference path="../pb_data/types.d.ts" />
+
+// Aggregation route used by PocketbaseExtended::aggregate().
+//
+// Copy this file and pbext_filter.js into the pb_hooks directory of the PocketBase server (v0.23+).
+// Devices get count/avg/min/max per time bucket instead of downloading every record,
+// so the response size depends on the number of buckets, not on the number of records.
+//
+// GET /api/pbext/aggregate/{collection}?field=temperature&bucket=day&timeField=created&filter=...
+//
+// Response:
+// {"field":"temperature","bucket":"day","items":[["2024-01-20",24,21.5,19,23.1],...]}
+// where each item is [bucket start, count, avg, min, max].
+//
+// Only authenticated requests are served, and only records passing the collection list rule for the caller
+// are aggregated. The filter and the list rule go through pbext_filter.js, as in pbext_digest.pb.js, and
+// field and timeField must be fields of the collection the caller can see. Filtering, the rule and the
+// grouping run as one SQL query; records with an empty timeField fall in the "" bucket.
+
+routerAdd("GET", "/api/pbext/aggregate/{collection}", (e) => {
+    const pbextFilter = require(`${__hooks}/pbext_filter.js`);
+    // Length of the "YYYY-MM-DD HH:MM:SS" prefix identifying each bucket
+    const BUCKET_PREFIX = { minute: 16, hour: 13, day: 10, month: 7, year: 4 };
+    const IDENTIFIER = /^[A-Za-z0-9_]+$/;
+
+    const collectionName = e.request.pathValue("collection");
+    const field = e.request.url.query().get("field");
+    const bucket = e.request.url.query().get("bucket") || "day";
+    const timeField = e.request.url.query().get("timeField") || "created";
+    const filter = e.request.url.query().get("filter") || "";
+
+    if (!IDENTIFIER.test(field) || !IDENTIFIER.test(timeField) || !(bucket in BUCKET_PREFIX)) {
+        throw new BadRequestError("Invalid field, timeField or bucket.");
+    }
+
+    const collection = $app.findCollectionByNameOrId(collectionName);
+    const rule = pbextFilter.listRuleSql(collection, e);
+    const where = pbextFilter.clientFilterSql(collection, e, filter);
+
+    // Min and max of a hidden field would leak it as much as a filter on it
+    const isSuperuser = e.auth && e.auth.isSuperuser();
+    for (const name of [field, timeField]) {
+        const found = collection.fields.getByName(name);
+        if (!found || (found.getHidden() && !isSuperuser)) {
+            throw new BadRequestError("Unknown field '" + name + "'.");
+        }
+    }
+
+    const rows = arrayOf(new DynamicModel({ bucket: "", count: 0, avg: -0, min: -0, max: -0 }));
+    $app.db()
+        .newQuery("SELECT substr([[" + timeField + "]], 1, " + BUCKET_PREFIX[bucket] + ") AS [[bucket]], " +
+            "COUNT(*) AS [[count]], AVG(COALESCE([[" + field + "]], 0)) AS [[avg]], " +
+            "MIN(COALESCE([[" + field + "]], 0)) AS [[min]], MAX(COALESCE([[" + field + "]], 0)) AS [[max]] " +
+            "FROM {{" + collection.name + "}} WHERE " + rule.sql + " AND " + where.sql + " " +
+            "GROUP BY [[bucket]] ORDER BY [[bucket]]")
+        .bind(Object.assign({}, rule.params, where.params))
+        .all(rows);
+
+    const items = rows.map((row) => [row.bucket, row.count, row.avg, row.min, row.max]);
+    return e.json(200, { field: field, bucket: bucket, items: items });
+}, $apis.requireAuth());
@@ -0,0 +1,82 @@
+/// <reference path="../pb_data/types.d.ts" />
+
+// Range digest route used by PocketbaseExtended::reconcile().
+//
+// Copy this file and pbext_filter.js into the pb_hooks directory of the PocketBase server (v0.23+).
+// Devices keeping a local copy of a collection compare these digests with their own, and only
+// list the ids of the ranges that differ, so deleted records are found with a transfer that
+// depends on the number of differences, not on the size of the collection.
+//
+// GET /api/pbext/digest/{collection}?ranges=32&low=0&high=46656&filter=...
+//
+// Ids are split on their first 3 characters read as a base 36 number p (0 to 46655): only ids
+// with low <= p < high are digested, and an id goes into range floor((p - low) * ranges / (high - low)).
+//
+// Response:
+// {"ranges":32,"items":[[12,3735928559],[0,0],...]}
+// where each item is [number of ids, XOR of the 32-bit FNV-1a hashes of the ids].
+//
+// Only authenticated requests are served, and only records passing the collection list rule for the caller
+// are digested. The filter and the list rule go through pbext_filter.js (copy it next to this file), which
+// accepts comparisons of the collection's own fields and refuses hidden fields to non-superusers; the query
+// reads the ids only.
+
+routerAdd("GET", "/api/pbext/digest/{collection}", (e) => {
+    const pbextFilter = require(`${__hooks}/pbext_filter.js`);
+    const PREFIX_COUNT = 36 * 36 * 36;
+    const MAX_RANGES = 256;
+
+    const collectionName = e.request.pathValue("collection");
+    const ranges = parseInt(e.request.url.query().get("ranges") || "32", 10);
+    const low = parseInt(e.request.url.query().get("low") || "0", 10);
+    const high = parseInt(e.request.url.query().get("high") || String(PREFIX_COUNT), 10);
+    const filter = e.request.url.query().get("filter") || "";
+
+    if (!(ranges >= 1 && ranges <= MAX_RANGES && low >= 0 && high > low && high <= PREFIX_COUNT)) {
+        throw new BadRequestError("Invalid ranges, low or high.");
+    }
+
+    const collection = $app.findCollectionByNameOrId(collectionName);
+    const rule = pbextFilter.listRuleSql(collection, e);
+    const where = pbextFilter.clientFilterSql(collection, e, filter);
+
+    // Smallest id with the given prefix, used to bound the query
+    const prefixId = (p) => p.toString(36).padStart(3, "0") + "000000000000";
+
+    const params = Object.assign({ low: prefixId(low), high: prefixId(high) }, rule.params, where.params);
+    let bounds = "[[id]] >= {:low}";
+    if (high < PREFIX_COUNT) {
+        bounds += " AND [[id]] < {:high}";
+    }
+    const rows = arrayOf(new DynamicModel({ id: "" }));
+    $app.db()
+        .newQuery("SELECT [[id]] FROM {{" + collection.name + "}} WHERE " + bounds + " AND " + rule.sql + " AND " +
+            where.sql)
+        .bind(params)
+        .all(rows);
+
+    const items = [];
+    for (let i = 0; i < ranges; i++) {
+        items.push([0, 0]);
+    }
+
+    for (const row of rows) {
+        const id = row.id;
+        const p = parseInt(id.substring(0, 3), 36);
+        if (!(p >= low && p < high)) {
+            continue;
+        }
+
+        // FNV-1a, the same hash as the device
+        let hash = 0x811c9dc5;
+        for (let i = 0; i < id.length; i++) {
+            hash = Math.imul(hash ^ id.charCodeAt(i), 0x01000193);
+        }
+
+        const item = items[Math.floor((p - low) * ranges / (high - low))];
+        item[0]++;
+        item[1] = (item[1] ^ hash) >>> 0;
+    }
+
+    return e.json(200, { ranges: ranges, items: items });
+}, $apis.requireAuth());
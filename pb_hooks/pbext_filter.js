@@ -0,0 +1,218 @@
+/// <reference path="../pb_data/types.d.ts" />
+
+// Filters of the pbext routes, translated to a SQL condition on the columns of one collection.
+//
+// Loaded with require() by pbext_aggregate.pb.js and pbext_digest.pb.js: copy it into the same pb_hooks
+// directory. It does not end with .pb.js, so PocketBase does not run it as a hook of its own.
+//
+// $app.findRecordsByFilter() resolves every field, hidden ones included, and @collection joins, so a client
+// filter passed to it lets the caller learn hidden values and other collections from what matches. The list
+// API resolves client filters against the caller's request instead, without hidden fields, and the hooks
+// cannot reach that resolver. This one accepts the subset of the filter syntax that is safe to hand to a
+// client and simple to put in SQL:
+//
+//   field op literal, literal op field, field op field, joined with && and || and grouped with ( )
+//   op: = != > >= < <= ~ !~       literal: 'text' "text" 12 -1.5 true false null
+//
+// where field is a field of the collection itself. Hidden fields are refused unless options.hidden is set
+// (superusers, as in the list API). With options.auth, used for the list rule of the collection,
+// @request.auth.<field> is also accepted and bound to the value of the caller's auth record (null when not
+// authenticated). Anything else (@collection, @request.query, relation paths, ?= operators, modifiers)
+// throws, and the routes answer 400 for a client filter and 403 for a list rule.
+
+const TOKEN = /\s*(?:(\(|\)|&&|\|\||!=|>=|<=|!~|=|>|<|~)|'((?:[^'\\]|\\.)*)'|"((?:[^"\\]|\\.)*)"|(-?\d+(?:\.\d+)?)(?![\w.])|(@?[A-Za-z_][\w.:]*)|(\S))/y;
+const OPERATORS = { "=": "=", "!=": "!=", ">": ">", ">=": ">=", "<": "<", "<=": "<=", "~": "LIKE", "!~": "NOT LIKE" };
+const FIELD = /^[A-Za-z_]\w*$/;
+
+function tokenize(filter) {
+    const tokens = [];
+    TOKEN.lastIndex = 0;
+    while (TOKEN.lastIndex < filter.length) {
+        const m = TOKEN.exec(filter);
+        if (m === null) {
+            break; // Trailing spaces
+        }
+        if (m[1] !== undefined) {
+            tokens.push({ symbol: m[1] });
+        } else if (m[2] !== undefined || m[3] !== undefined) {
+            const text = m[2] !== undefined ? m[2] : m[3];
+            tokens.push({ value: text.replace(/\\(.)/g, "$1"), text: true });
+        } else if (m[4] !== undefined) {
+            tokens.push({ value: parseFloat(m[4]) });
+        } else if (m[5] !== undefined) {
+            tokens.push({ name: m[5] });
+        } else {
+            throw new Error("unexpected '" + m[6] + "'");
+        }
+    }
+    return tokens;
+}
+
+/**
+ * Translates filter into {sql, params}: sql is a condition on the columns of collection's table ("1" for an
+ * empty filter), to run with $app.db().newQuery(...).bind(params). Parameter names start with prefix.
+ *
+ * options.hidden    hidden fields may be used
+ * options.auth      @request.auth.<field> may be used, bound from this auth record (null when not authenticated)
+ */
+function toSql(collection, filter, prefix, options) {
+    options = options || {};
+    const tokens = tokenize(filter || "");
+    const params = {};
+    let position = 0;
+
+    const peek = () => tokens[position];
+    const isSymbol = (symbol) => position < tokens.length && tokens[position].symbol === symbol;
+    const expect = (symbol) => {
+        if (!isSymbol(symbol)) {
+            throw new Error("expected '" + symbol + "'");
+        }
+        position++;
+    };
+    const bind = (value) => {
+        const name = prefix + Object.keys(params).length;
+        params[name] = value;
+        return name;
+    };
+
+    // A column, a bound literal or a bound auth value; text is the parameter name of a text literal
+    const operand = () => {
+        const token = peek();
+        if (token === undefined || token.symbol !== undefined) {
+            throw new Error("expected a field or a value");
+        }
+        position++;
+
+        if (token.name === undefined) {
+            const name = bind(token.value);
+            return { sql: "{:" + name + "}", text: token.text === true ? name : undefined };
+        }
+        if (token.name === "true" || token.name === "false") {
+            return { sql: token.name === "true" ? "1" : "0" };
+        }
+        if (token.name === "null") {
+            return { sql: "NULL" };
+        }
+        if (token.name.startsWith("@request.auth.") && options.auth !== undefined) {
+            const field = token.name.substring(14);
+            if (!FIELD.test(field)) {
+                throw new Error("unsupported '" + token.name + "'");
+            }
+            const auth = options.auth;
+            let value = null;
+            if (auth) {
+                value = field === "id" ? auth.id : field === "collectionName" ? auth.collection().name : auth.get(field);
+            }
+            return { sql: "{:" + bind(value === undefined ? null : value) + "}" };
+        }
+        if (!FIELD.test(token.name)) {
+            throw new Error("unsupported '" + token.name + "'");
+        }
+        const field = collection.fields.getByName(token.name);
+        if (!field || (field.getHidden() && !options.hidden)) {
+            throw new Error("unknown field '" + token.name + "'");
+        }
+        return { sql: "[[" + token.name + "]]" };
+    };
+
+    // Null compares equal to the empty value, as in PocketBase filters
+    const comparison = () => {
+        const left = operand();
+        const token = peek();
+        if (token === undefined || OPERATORS[token.symbol] === undefined) {
+            throw new Error("expected an operator");
+        }
+        position++;
+        const right = operand();
+
+        switch (token.symbol) {
+            case "=":
+                return "COALESCE(" + left.sql + ", '') = COALESCE(" + right.sql + ", '')";
+            case "!=":
+                return "COALESCE(" + left.sql + ", '') != COALESCE(" + right.sql + ", '')";
+            case "~":
+            case "!~":
+                if (right.text === undefined) {
+                    throw new Error("'" + token.symbol + "' needs a text value");
+                }
+                // Without a wildcard, contains
+                if (!params[right.text].includes("%")) {
+                    params[right.text] = "%" + params[right.text] + "%";
+                }
+                return left.sql + " " + OPERATORS[token.symbol] + " " + right.sql + " ESCAPE '\\'";
+            default:
+                return left.sql + " " + OPERATORS[token.symbol] + " " + right.sql;
+        }
+    };
+
+    const group = () => {
+        if (isSymbol("(")) {
+            position++;
+            const inner = or();
+            expect(")");
+            return "(" + inner + ")";
+        }
+        return comparison();
+    };
+
+    const and = () => {
+        let sql = group();
+        while (isSymbol("&&")) {
+            position++;
+            sql += " AND " + group();
+        }
+        return sql;
+    };
+
+    const or = () => {
+        let sql = and();
+        while (isSymbol("||")) {
+            position++;
+            sql += " OR " + and();
+        }
+        return sql;
+    };
+
+    if (tokens.length === 0) {
+        return { sql: "1", params: params };
+    }
+    const sql = or();
+    if (position < tokens.length) {
+        throw new Error("unexpected token after the end of the filter");
+    }
+    return { sql: "(" + sql + ")", params: params };
+}
+
+/**
+ * The condition restricting a query on collection to the records the caller may list, as {sql, params}, or
+ * throws ForbiddenError: only superusers pass a null list rule, and a rule outside of what toSql() accepts
+ * cannot be applied here.
+ */
+function listRuleSql(collection, e) {
+    const isSuperuser = e.auth && e.auth.isSuperuser();
+    if (isSuperuser || collection.listRule === "") {
+        return { sql: "1", params: {} };
+    }
+    if (collection.listRule === null) {
+        throw new ForbiddenError("Only superusers can access this collection.");
+    }
+    try {
+        return toSql(collection, collection.listRule, "rule", { hidden: true, auth: e.auth || null });
+    } catch (err) {
+        throw new ForbiddenError("The list rule of this collection is not supported by this route (" + err.message +
+            "), only superusers can use it.");
+    }
+}
+
+/**
+ * The client filter of the request as {sql, params}, or throws BadRequestError.
+ */
+function clientFilterSql(collection, e, filter) {
+    try {
+        return toSql(collection, filter, "filter", { hidden: e.auth && e.auth.isSuperuser() });
+    } catch (err) {
+        throw new BadRequestError("Unsupported filter: " + err.message + ".");
+    }
+}
+
+module.exports = { toSql, listRuleSql, clientFilterSql };
@@ -0,0 +1,130 @@
+// bench.h
+//
+// Shared by the bench_*.cpp: benchRun() times a loop and counts the heap allocations it makes, benchMetric()
+// records a value measured otherwise (ex. on the simulated clock), and benchFinish() writes every result as JSON
+// next to the binary, ex. build/bench_url.json, for tools/bench_compare.py:
+//
+//   {"bench_url": {"collection": {"ns": 41.2, "allocs": 1, "bytes": 32}, ...}}
+//
+// Include it from a single file of the bench: it replaces the global operator new and delete.
+
+#ifndef bench_h
+#define bench_h
+
+#include <chrono>
+#include <map>
+#include <new>
+#include <cstddef>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+static size_t bench_allocations = 0;
+static size_t bench_allocated = 0;
+static size_t bench_live = 0;
+static size_t bench_peak = 0;
+
+// Each block starts with its size, so that delete can keep the live total
+static const size_t BENCH_HEADER = alignof(std::max_align_t);
+
+void *operator new(size_t size)
+{
+    char *block = (char *)malloc(size + BENCH_HEADER);
+    if (block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    *(size_t *)block = size;
+    bench_allocations++;
+    bench_allocated += size;
+    bench_live += size;
+    bench_peak = bench_live > bench_peak ? bench_live : bench_peak;
+    return block + BENCH_HEADER;
+}
+
+// Not inlined: GCC would take the free() of the block for a mismatch with the new of the caller
+__attribute__((noinline)) void operator delete(void *pointer) noexcept
+{
+    if (pointer != nullptr)
+    {
+        char *block = (char *)pointer - BENCH_HEADER;
+        bench_live -= *(size_t *)block;
+        free(block);
+    }
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete[](void *pointer) noexcept { operator delete(pointer); }
+void operator delete(void *pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { operator delete(pointer); }
+
+// Results by bench case, then by metric
+static std::map<std::string, std::map<std::string, double>> bench_results;
+
+static inline void benchMetric(const char *name, const char *metric, double value)
+{
+    bench_results[name][metric] = value;
+}
+
+// Runs body runs times in 5 rounds, then records and prints the time of the fastest round (the least disturbed by
+// the rest of the machine), the allocations and the allocated bytes per run
+template <typename Body>
+static void benchRun(const char *name, int runs, Body body)
+{
+    const int rounds = 5;
+    size_t allocations = bench_allocations;
+    size_t allocated = bench_allocated;
+    double ns = 0;
+    for (int round = 0; round < rounds; round++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = round * runs / rounds; i < (round + 1) * runs / rounds; i++)
+        {
+            body(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        double roundNs = std::chrono::duration<double, std::nano>(end - start).count() / (runs / rounds);
+        ns = round == 0 || roundNs < ns ? roundNs : ns;
+    }
+
+    double allocs = (double)(bench_allocations - allocations) / runs;
+    double bytes = (double)(bench_allocated - allocated) / runs;
+    benchMetric(name, "ns", ns);
+    benchMetric(name, "allocs", allocs);
+    benchMetric(name, "bytes", bytes);
+    printf("%s: %.1f ns, %.2f allocations, %.0f bytes\n", name, ns, allocs, bytes);
+}
+
+// Writes the results to <program>.json, returns the exit code of the bench
+static inline int benchFinish(const char *program)
+{
+    std::string path = std::string(program) + ".json";
+    std::string bench = program;
+    bench = bench.substr(bench.find_last_of('/') + 1);
+
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        perror(path.c_str());
+        return 1;
+    }
+    fprintf(file, "{\"%s\": {", bench.c_str());
+    const char *separator = "";
+    for (const auto &result : bench_results)
+    {
+        fprintf(file, "%s\n  \"%s\": {", separator, result.first.c_str());
+        const char *metricSeparator = "";
+        for (const auto &metric : result.second)
+        {
+            fprintf(file, "%s\"%s\": %.6g", metricSeparator, metric.first.c_str(), metric.second);
+            metricSeparator = ", ";
+        }
+        fprintf(file, "}");
+        separator = ",";
+    }
+    fprintf(file, "\n}}\n");
+    fclose(file);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,32 @@
+// Host microbenchmark of PocketbaseJsonWriter against printf formatting of the same body. Timings are of the host
+// CPU: they compare the two approaches, the boards are several times slower on both.
+
+#include "PocketbaseJson.h"
+#include "bench.h"
+
+int main(int argc, char **argv)
+{
+    (void)argc;
+    const int runs = 1000000;
+    static volatile float temperature = 21.37f;
+    String body;
+    body.reserve(128);
+
+    benchRun("body_printf", runs, [&](int i) {
+        char number[16];
+        body = "{\"temperature\":";
+        snprintf(number, sizeof(number), "%.7g", (double)(temperature + i));
+        body += number;
+        body += ",\"counter\":";
+        snprintf(number, sizeof(number), "%ld", (long)i);
+        body += number;
+        body += "}";
+    });
+    benchRun("body_writer", runs, [&](int i) {
+        body = "";
+        PocketbaseJsonWriter json(body);
+        json.beginObject().field("temperature", (float)(temperature + i)).field("counter", (long)i).endObject();
+    });
+
+    return benchFinish(argv[0]);
+}
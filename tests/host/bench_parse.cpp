@@ -0,0 +1,43 @@
+// Host microbenchmark of the decoder number and timestamp parsers against the C library. Timings are of the
+// host CPU: they compare the two approaches, the boards are several times slower on both.
+
+#include "PocketbaseJson.h"
+#include "PocketbaseTime.h"
+#include "bench.h"
+#include <time.h>
+
+int main(int argc, char **argv)
+{
+    (void)argc;
+    const int runs = 5000000;
+    static const char *values[] = {"21.5", "1013.25", "-0.125", "48.37"};
+    static const char *timestamp = "2024-01-20 12:34:56.789Z";
+    static volatile float floatSink = 0;
+    static volatile long long timeSink = 0;
+
+    benchRun("float_strtof", runs, [](int i) {
+        floatSink = floatSink + strtof(values[i & 3], nullptr);
+    });
+    benchRun("float_pocketbaseParseFloat", runs, [](int i) {
+        float value;
+        pocketbaseParseFloat(values[i & 3], value);
+        floatSink = floatSink + value;
+    });
+
+    benchRun("timestamp_sscanf_timegm", runs, [](int) {
+        struct tm parts = {};
+        int ms;
+        sscanf(timestamp, "%d-%d-%d %d:%d:%d.%dZ", &parts.tm_year, &parts.tm_mon, &parts.tm_mday, &parts.tm_hour,
+               &parts.tm_min, &parts.tm_sec, &ms);
+        parts.tm_year -= 1900;
+        parts.tm_mon--;
+        timeSink = timeSink + timegm(&parts) * 1000LL + ms;
+    });
+    benchRun("timestamp_pocketbaseParseTimestamp", runs, [](int) {
+        int64_t ms;
+        pocketbaseParseTimestamp(timestamp, ms);
+        timeSink = timeSink + ms;
+    });
+
+    return benchFinish(argv[0]);
+}
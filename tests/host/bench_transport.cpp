@@ -0,0 +1,81 @@
+// Host measurement of the round trip of create() over simulated links (see HostLink): HTTPClient, which writes
+// the head and the body separately and leaves Nagle on, against the coalesced writes of the library. Times are
+// those of the simulated clock, not of the host CPU.
+
+#include "PocketbaseExtended.h"
+#include "bench.h"
+
+#if PB_ENABLE_COALESCED_WRITES
+
+struct Link
+{
+    const char *name;
+    HostLink link;
+};
+
+// What attemptRequest() does for a body when PB_ENABLE_COALESCED_WRITES is 0
+static unsigned long httpClientMs(const char *url, const String &body)
+{
+    unsigned long before = host::now;
+    PocketbaseSecureClient client;
+    client.setInsecure();
+    HTTPClient http;
+    http.begin(client, url);
+    http.addHeader("Content-Type", "application/json");
+    http.sendRequest("POST", body);
+    http.end();
+    return host::now - before;
+}
+
+static unsigned long coalescedMs(PocketbaseExtended &pb, const String &body)
+{
+    unsigned long before = host::now;
+    pb.create(body);
+    return host::now - before;
+}
+
+int main(int argc, char **argv)
+{
+    (void)argc;
+    static const Link links[] = {
+        {"wifi", {20, 1000000, 0, 0, 0, 200, 1460}},
+        {"wifi-lm", {20, 1000000, 0, 0, 0, 200, 536}},
+        {"cellular", {150, 50000, 0, 0, 0, 200, 1460}},
+    };
+    static const size_t bodySizes[] = {64, 700, 3000};
+
+    for (const Link &link : links)
+    {
+        for (size_t bodySize : bodySizes)
+        {
+            host::reset();
+            host::handler = [](const HostRequest &) { return HostReply(200, "{\"id\":\"abcdefghijklmno\"}"); };
+            host::link = link.link;
+            PocketbaseExtended pb("https://pb.example.com/");
+            pb.collection("readings");
+            String body(std::string(bodySize, 'x'));
+
+            unsigned long httpClient = httpClientMs("https://pb.example.com/api/collections/readings/records/", body);
+            host::now += 1000;
+            unsigned long coalesced = coalescedMs(pb, body);
+
+            std::string name = std::string("create/") + link.name + "/" + std::to_string(bodySize);
+            benchMetric(name.c_str(), "httpclient_ms", httpClient);
+            benchMetric(name.c_str(), "coalesced_ms", coalesced);
+            printf("create %s body=%u: HTTPClient %lu ms, coalesced %lu ms\n", link.name, (unsigned)bodySize,
+                   httpClient, coalesced);
+        }
+    }
+    return benchFinish(argv[0]);
+}
+
+#else
+
+int main(int argc, char **argv)
+{
+    (void)argc;
+    printf("create: coalesced writes disabled\n");
+    return benchFinish(argv[0]);
+}
+
+#endif
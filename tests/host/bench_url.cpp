@@ -0,0 +1,74 @@
+// Host microbenchmark of the string handling on the request path: base URL normalization, collection(), getList()
+// with its 7 parameters, percent-encoding, request head formatting and response body copy. Requests go through
+// the stub HTTPClient and WiFiClient, with logging on as in the default build, so the timings are of the whole
+// path on the host CPU; the allocation counts are those of the library and the Arduino String stand-in.
+
+#include "PocketbaseExtended.h"
+#include "bench.h"
+
+int main(int argc, char **argv)
+{
+    (void)argc;
+    const int runs = 100000;
+    static std::string answer = "{\"id\":\"abcdefghijklmno\"}";
+    host::handler = [](const HostRequest &) { return HostReply(200, answer); };
+
+    // Base URL normalization: scheme, host, port and path prefix parsed, "/api/" appended
+    benchRun("constructor", runs, [](int) {
+        PocketbaseExtended pb("https://pb.example.com:8443/pb/");
+    });
+
+    PocketbaseExtended pb("http://pb.example.com/pb");
+    benchRun("collection", runs, [&](int) {
+        pb.collection("readings");
+    });
+
+    // Every request: clear the log of the stub Serial and stay under the rate limit
+    auto request = [&](int, auto send) {
+        host::serial.clear();
+        host::now += 1000;
+        send();
+    };
+
+    benchRun("getList_7_params", runs, [&](int i) {
+        request(i, [&] {
+            pb.collection("readings").getList("2", "50", "-created", "device = 'abc'", "true", "device", "id,temperature");
+        });
+    });
+
+    // Filters of the same length, one without a character to escape and one escaped nearly throughout
+    benchRun("filter_safe", runs, [&](int i) {
+        request(i, [&] {
+            pb.collection("readings").getList(nullptr, nullptr, nullptr, "device_abc_temperature_210", nullptr, nullptr, nullptr);
+        });
+    });
+    benchRun("filter_escaped", runs, [&](int i) {
+        request(i, [&] {
+            pb.collection("readings").getList(nullptr, nullptr, nullptr, "' ' && '%' || '&' = '#' &&", nullptr, nullptr, nullptr);
+        });
+    });
+
+#if PB_ENABLE_COALESCED_WRITES
+    // Request line and headers formatted by hand, with the body in the same buffer
+    benchRun("create_head", runs, [&](int i) {
+        request(i, [&] {
+            pb.collection("readings").create("{\"temperature\":21.5}");
+        });
+    });
+#endif
+
+    // The response body copied from the transport to the caller, small and 16 KB (a full TLS record)
+    benchRun("getOne_small_body", runs, [&](int i) {
+        request(i, [&] {
+            pb.collection("readings").getOne("abcdefghijklmno", nullptr, nullptr);
+        });
+    });
+    answer = "{\"items\":[\"" + std::string(16384, 'x') + "\"]}";
+    benchRun("getOne_16k_body", runs / 10, [&](int i) {
+        request(i, [&] {
+            pb.collection("readings").getOne("abcdefghijklmno", nullptr, nullptr);
+        });
+    });
+
+    return benchFinish(argv[0]);
+}
@@ -0,0 +1,158 @@
+// Workloads of a device run against simulated links (see HostLink), on the simulated clock:
+//
+//   polling      getList() of the records changed since the last poll, every 10 s, mostly empty answers
+//   bulk upload  create() of readings back to back, waiting out the client-side rate limit
+//   full sync    getList() of every page of a 1000 record collection
+//
+// Each reports the operations per second of simulated time, the latency percentiles of an operation, the radio-on
+// time from stats() and its share of the run, the bytes sent on the link per operation (TLS included) and
+// received per operation, and the peak of the host heap in use during the run, the stubs' buffers included.
+
+#include "PocketbaseExtended.h"
+#include "bench.h"
+#include "host_test.h"
+#include <algorithm>
+#include <vector>
+
+#if PB_ENABLE_STATS
+
+struct Link
+{
+    const char *name;
+    HostLink link;
+};
+
+typedef std::function<HostReply(const HostRequest &)> Handler;
+
+static std::string record(int index)
+{
+    char json[128];
+    snprintf(json, sizeof(json), "{\"id\":\"r%014d\",\"device\":\"esp-01\",\"temperature\":%d.5,"
+                                 "\"created\":\"2024-01-20 08:00:00.000Z\"}", index, 15 + index % 10);
+    return json;
+}
+
+static unsigned long percentile(const std::vector<unsigned long> &sorted, int percent)
+{
+    size_t rank = (sorted.size() * percent + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+template <typename Operation>
+static void runWorkload(const Link &link, const char *workload, const Handler &handler, int operations,
+                        unsigned long intervalMs, Operation operation)
+{
+    std::string name = std::string(workload) + "/" + link.name;
+    std::vector<unsigned long> latencies;
+    latencies.reserve(operations);
+
+    host::reset();
+    host::link = link.link;
+    host::handler = handler;
+    // Buffers of the stubs kept from the previous run would hide what this one allocates
+    std::string().swap(host::serial);
+    std::string().swap(host::sent);
+    size_t heapBefore = bench_live;
+    bench_peak = heapBefore;
+
+    size_t wireBytes = 0;
+    unsigned long start = host::now;
+    {
+        PocketbaseExtended pb("https://pb.example.com/");
+        pb.collection("readings");
+        for (int i = 0; i < operations; i++)
+        {
+            unsigned long due = start + i * intervalMs;
+            host::now = std::max(host::now, due);
+            host::serial.clear();
+
+            unsigned long began = host::now;
+            operation(pb, i);
+            // A device waits for the rate limit to let the request through
+            while (pb.lastStatusCode() == PB_ERROR_THROTTLED)
+            {
+                host::now += 100;
+                began = host::now;
+                operation(pb, i);
+            }
+            latencies.push_back(host::now - began);
+            wireBytes += host::wireBytes;
+        }
+
+        const PocketbaseStats &stats = pb.stats();
+        unsigned long elapsed = host::now - start;
+        std::sort(latencies.begin(), latencies.end());
+
+        benchMetric(name.c_str(), "ops_per_s", operations * 1000.0 / elapsed);
+        benchMetric(name.c_str(), "p50_ms", percentile(latencies, 50));
+        benchMetric(name.c_str(), "p95_ms", percentile(latencies, 95));
+        benchMetric(name.c_str(), "p99_ms", percentile(latencies, 99));
+        benchMetric(name.c_str(), "radio_on_ms", stats.radioOnMs);
+        benchMetric(name.c_str(), "radio_on_percent", stats.radioOnMs * 100.0 / elapsed);
+        benchMetric(name.c_str(), "wire_sent_per_op", (double)wireBytes / operations);
+        benchMetric(name.c_str(), "received_per_op", (double)stats.bytesReceived / operations);
+        benchMetric(name.c_str(), "failures", stats.failures);
+        printf("%s: %.2f ops/s, p50 %lu ms, p95 %lu ms, p99 %lu ms, radio on %u ms (%.1f%%), %.0f bytes sent and "
+               "%.0f received per op, %u failures, ",
+               name.c_str(), operations * 1000.0 / elapsed, percentile(latencies, 50), percentile(latencies, 95),
+               percentile(latencies, 99), (unsigned)stats.radioOnMs, stats.radioOnMs * 100.0 / elapsed,
+               (double)wireBytes / operations, (double)stats.bytesReceived / operations, (unsigned)stats.failures);
+    }
+    benchMetric(name.c_str(), "peak_heap", bench_peak - heapBefore);
+    printf("peak heap %u bytes\n", (unsigned)(bench_peak - heapBefore));
+}
+
+int main(int argc, char **argv)
+{
+    (void)argc;
+    // rtt, throughput, loss, RTO, TLS handshake CPU, server delayed ACK, MSS
+    static const Link links[] = {
+        {"wifi", {20, 1000000, 0, 200, 300, 40, 1460}},
+        {"wifi-lossy", {30, 500000, 5, 300, 300, 40, 1460}},
+        {"cellular", {150, 50000, 1, 1000, 300, 40, 1460}},
+    };
+
+    // Nine polls out of ten find nothing new
+    Handler polling = [](const HostRequest &request) {
+        bool changed = queryParam(request.url, "filter").find("updated >") != std::string::npos &&
+                       host::requests % 10 == 0;
+        return HostReply(200, std::string("{\"page\":1,\"perPage\":20,\"items\":[") + (changed ? record(1) : "") + "]}");
+    };
+    Handler upload = [](const HostRequest &) { return HostReply(200, record(0)); };
+    Handler sync = [](const HostRequest &request) {
+        int page = atoi(queryParam(request.url, "page").c_str());
+        int perPage = atoi(queryParam(request.url, "perPage").c_str());
+        std::string body = "{\"page\":" + std::to_string(page) + ",\"perPage\":" + std::to_string(perPage) + ",\"items\":[";
+        for (int i = (page - 1) * perPage; i < page * perPage && i < 1000; i++)
+        {
+            body += (i % perPage != 0 ? "," : "") + record(i);
+        }
+        return HostReply(200, body + "]}");
+    };
+
+    for (const Link &link : links)
+    {
+        runWorkload(link, "polling", polling, 100, 10000, [](PocketbaseExtended &pb, int) {
+            pb.getList(nullptr, "20", nullptr, "updated > '2024-01-20 08:00:00'", "true", nullptr, nullptr);
+        });
+        runWorkload(link, "bulk_upload", upload, 100, 0, [](PocketbaseExtended &pb, int i) {
+            pb.create(String(record(i).c_str()));
+        });
+        runWorkload(link, "full_sync", sync, 10, 0, [](PocketbaseExtended &pb, int i) {
+            pb.getList(String(i + 1).c_str(), "100", "id", nullptr, "true", nullptr, nullptr);
+        });
+    }
+
+    return benchFinish(argv[0]);
+}
+
+#else
+
+int main(int argc, char **argv)
+{
+    (void)argc;
+    printf("workloads: stats disabled\n");
+    return benchFinish(argv[0]);
+}
+
+#endif
@@ -0,0 +1,60 @@
+// host_test.h
+//
+// Minimal checks for the host tests: CHECK() reports the failing line and testsPassed() sets the exit code.
+
+#ifndef host_test_h
+#define host_test_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+static int checks_failed = 0;
+
+#define CHECK(condition)                                                    \
+    do                                                                      \
+    {                                                                       \
+        if (!(condition))                                                   \
+        {                                                                   \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            checks_failed++;                                                \
+        }                                                                   \
+    } while (0)
+
+static inline int testsPassed(const char *name)
+{
+    printf("%s: %s\n", name, checks_failed == 0 ? "ok" : "FAILED");
+    return checks_failed == 0 ? 0 : 1;
+}
+
+// Decoded value of a query parameter of url, empty when it is missing
+static inline std::string queryParam(const std::string &url, const char *name)
+{
+    std::string key = std::string(name) + "=";
+    size_t start = url.find('?');
+    while (start != std::string::npos && url.compare(start + 1, key.size(), key) != 0)
+    {
+        start = url.find('&', start + 1);
+    }
+    if (start == std::string::npos)
+    {
+        return "";
+    }
+
+    std::string value;
+    for (size_t i = start + 1 + key.size(); i < url.size() && url[i] != '&'; i++)
+    {
+        if (url[i] == '%' && i + 2 < url.size())
+        {
+            value += (char)strtol(url.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        }
+        else
+        {
+            value += url[i] == '+' ? ' ' : url[i];
+        }
+    }
+    return value;
+}
+
+#endif
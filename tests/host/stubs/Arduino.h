@@ -0,0 +1,238 @@
+// Arduino.h
+//
+// Host stand-in for the Arduino core: just what the library uses, on top of the C++ standard library.
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <memory>
+#include <string>
+#include <utility>
+
+#define ESP8266 1
+
+typedef bool boolean;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer);
+
+class __FlashStringHelper;
+#define F(x) (reinterpret_cast<const __FlashStringHelper *>(x))
+#define PROGMEM
+#define PSTR(x) (x)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define strncmp_P strncmp
+#define strlen_P strlen
+#define memcpy_P memcpy
+
+class String
+{
+public:
+    String(const char *text = "") : s(text != nullptr ? text : "") {}
+    String(const char *text, unsigned int length) : s(text, length) {}
+    String(const std::string &text) : s(text) {}
+    String(const __FlashStringHelper *text) : s((const char *)text) {}
+    String(char c) : s(1, c) {}
+    String(int v, unsigned char base = 10) : s(number(v, base)) {}
+    String(unsigned int v, unsigned char base = 10) : s(number(v, base)) {}
+    String(long v, unsigned char base = 10) : s(number(v, base)) {}
+    String(unsigned long v, unsigned char base = 10) : s(number(v, base)) {}
+    String(long long v, unsigned char base = 10) : s(number(v, base)) {}
+    String(unsigned long long v, unsigned char base = 10) : s(number(v, base)) {}
+    String(float v, unsigned char decimals = 2) : s(fixed(v, decimals)) {}
+    String(double v, unsigned char decimals = 2) : s(fixed(v, decimals)) {}
+
+    const char *c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+    char charAt(unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    char &operator[](unsigned int i) { return s[i]; }
+
+    bool concat(const String &other) { s += other.s; return true; }
+    bool concat(const char *text) { s += text; return true; }
+    bool concat(const char *text, unsigned int length) { s.append(text, length); return true; }
+    bool concat(char c) { s += c; return true; }
+    bool concat(int v) { s += number(v, 10); return true; }
+    bool concat(unsigned int v) { s += number(v, 10); return true; }
+    bool concat(long v) { s += number(v, 10); return true; }
+    bool concat(unsigned long v) { s += number(v, 10); return true; }
+    template <typename T>
+    String &operator+=(const T &value) { concat(value); return *this; }
+
+    bool equals(const String &other) const { return s == other.s; }
+    bool equalsIgnoreCase(const String &other) const { return strcasecmp(c_str(), other.c_str()) == 0; }
+    bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String &suffix) const
+    {
+        return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const { return found(s.find(c, from)); }
+    int indexOf(const String &text, unsigned int from = 0) const { return found(s.find(text.s, from)); }
+    int lastIndexOf(char c) const { return found(s.rfind(c)); }
+    String substring(unsigned int from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const
+    {
+        return from < s.size() && from < to ? String(s.substr(from, to - from)) : String();
+    }
+    void remove(unsigned int from) { if (from < s.size()) s.erase(from); }
+    void remove(unsigned int from, unsigned int count) { if (from < s.size()) s.erase(from, count); }
+    void trim()
+    {
+        size_t first = s.find_first_not_of(" \t\r\n");
+        s = first == std::string::npos ? "" : s.substr(first, s.find_last_not_of(" \t\r\n") - first + 1);
+    }
+    void toLowerCase() { for (char &c : s) c = tolower((unsigned char)c); }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+
+    bool operator==(const String &other) const { return s == other.s; }
+    bool operator==(const char *other) const { return s == other; }
+    bool operator!=(const String &other) const { return s != other.s; }
+    explicit operator bool() const { return true; }
+
+    std::string s;
+
+private:
+    template <typename T>
+    static std::string number(T v, unsigned char base)
+    {
+        if (base == 10)
+        {
+            return std::to_string(v);
+        }
+        char buffer[72];
+        char *end = buffer + sizeof(buffer) - 1;
+        char *p = end;
+        *p = '\0';
+        unsigned long long u = (unsigned long long)v;
+        do
+        {
+            *--p = "0123456789abcdefghijklmnopqrstuvwxyz"[u % base];
+            u /= base;
+        } while (u > 0);
+        return p;
+    }
+    static std::string fixed(double v, unsigned char decimals)
+    {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, v);
+        return buffer;
+    }
+    static int found(size_t position) { return position == std::string::npos ? -1 : (int)position; }
+};
+
+inline String operator+(const String &a, const String &b) { return String(a.s + b.s); }
+inline String operator+(const String &a, const char *b) { return String(a.s + b); }
+inline String operator+(const char *a, const String &b) { return String(a + b.s); }
+inline String operator+(const String &a, char b) { return String(a.s + b); }
+
+class Print;
+
+class Printable
+{
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print &out) const = 0;
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) { return write(&c, 1); }
+    virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+    size_t write(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+
+    size_t print(const String &text) { return write((const uint8_t *)text.c_str(), text.length()); }
+    size_t print(const char *text) { return write(text); }
+    size_t print(const __FlashStringHelper *text) { return write((const char *)text); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v, int base = 10) { return print(String(v, base)); }
+    size_t print(unsigned int v, int base = 10) { return print(String(v, base)); }
+    size_t print(long v, int base = 10) { return print(String(v, base)); }
+    size_t print(unsigned long v, int base = 10) { return print(String(v, base)); }
+    size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+    size_t print(const Printable &x) { return x.printTo(*this); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T &value) { return print(value) + println(); }
+    template <typename T>
+    size_t println(const T &value, int format) { return print(value, format) + println(); }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char buffer[512];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return length > 0 ? write((const uint8_t *)buffer, length < (int)sizeof(buffer) ? length : sizeof(buffer) - 1) : 0;
+    }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+    virtual int read(uint8_t *buffer, size_t size)
+    {
+        size_t count = 0;
+        int c;
+        while (count < size && (c = read()) >= 0)
+        {
+            buffer[count++] = (uint8_t)c;
+        }
+        return (int)count;
+    }
+    size_t readBytes(uint8_t *buffer, size_t size) { return read(buffer, size); }
+    size_t readBytes(char *buffer, size_t size) { return read((uint8_t *)buffer, size); }
+    void setTimeout(unsigned long timeoutMs) { stream_timeout = timeoutMs; }
+
+protected:
+    unsigned long stream_timeout = 1000;
+};
+
+// Everything printed to Serial is appended to host::serial, see HostNet.h
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long) {}
+    using Print::write;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+};
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+    uint32_t getFreeHeap() { return 40000; }
+    uint32_t getMaxFreeBlockSize() { return 30000; }
+    uint32_t getFreeSketchSpace() { return 1 << 20; }
+    uint32_t getCycleCount() { return (uint32_t)micros() * 80; }
+    void restart() {}
+};
+extern EspClass ESP;
+
+#include "HostNet.h"
+
+#endif
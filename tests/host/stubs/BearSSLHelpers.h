@@ -0,0 +1,3 @@
+// BearSSLHelpers.h
+
+#include "ESP8266WiFi.h"
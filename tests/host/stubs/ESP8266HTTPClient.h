@@ -0,0 +1,73 @@
+// ESP8266HTTPClient.h
+//
+// Host stand-in for HTTPClient: every request is answered by host::handler, see HostNet.h.
+
+#ifndef ESP8266HTTPClient_h
+#define ESP8266HTTPClient_h
+
+#include "ESP8266WiFi.h"
+
+#define HTTPC_ERROR_CONNECTION_FAILED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_STREAM (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM (-8)
+#define HTTPC_ERROR_ENCODING (-9)
+#define HTTPC_ERROR_STREAM_WRITE (-10)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_PARTIAL_CONTENT 206
+
+class HTTPClient
+{
+public:
+    bool begin(WiFiClient &client, const String &url);
+    void end() {}
+    void setTimeout(uint16_t timeoutMs) { timeout_ms = timeoutMs; }
+    void setReuse(bool) {}
+    void addHeader(const String &name, const String &value, bool = false, bool = true);
+    void collectHeaders(const char *names[], const size_t count);
+
+    int GET() { return sendRequest("GET"); }
+    int POST(const String &payload) { return sendRequest("POST", payload); }
+    int PATCH(const String &payload) { return sendRequest("PATCH", payload); }
+    int sendRequest(const char *method, const String &payload = String());
+
+    int headers() { return (int)collected.size(); }
+    String header(size_t i);
+    String header(const char *name);
+    int getSize() { return reply.size >= 0 ? reply.size : (int)reply.body.size(); }
+    String getString();
+    WiFiClient *getStreamPtr() { return &body; }
+    static String errorToString(int error) { return String("error ") + String(error); }
+
+    uint16_t timeout_ms = 5000;
+
+private:
+    // The answer body, up to where the connection drops
+    class Body : public WiFiClient
+    {
+    public:
+        using WiFiClient::position;
+        int available() override;
+        int read() override;
+        int read(uint8_t *buffer, size_t size) override;
+        uint8_t connected() override { return position < limit; }
+
+        std::string data;
+        size_t limit = 0;
+    };
+
+    bool begun = false;
+    WiFiClient *client = nullptr;
+    HostRequest request;
+    HostReply reply;
+    std::vector<std::string> collected;
+    Body body;
+};
+
+#endif
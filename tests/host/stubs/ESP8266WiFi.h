@@ -0,0 +1,108 @@
+// ESP8266WiFi.h
+//
+// Host stand-in for the ESP8266 WiFi stack. Connections are served by HostNet.h.
+
+#ifndef ESP8266WiFi_h
+#define ESP8266WiFi_h
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include <vector>
+
+#define WL_CONNECTED 3
+
+class Client : public Stream
+{
+public:
+    virtual int connect(const char *host, uint16_t port) = 0;
+    virtual int connect(IPAddress ip, uint16_t port) = 0;
+    virtual void flush() {}
+    virtual void stop() = 0;
+    virtual uint8_t connected() = 0;
+    virtual operator bool() { return connected(); }
+};
+
+// A connection to the scripted server: the answer is host::wire when a test scripted one, or else what
+// host::handler returns for the request written.
+class WiFiClient : public Client
+{
+public:
+    int connect(const char *host, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port) override;
+    using Print::write;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buffer, size_t size) override;
+    int peek() override;
+    void stop() override { is_connected = false; }
+    uint8_t connected() override;
+    void setNoDelay(bool noDelay);
+    bool getNoDelay() { return no_delay; }
+    IPAddress remoteIP() { return IPAddress(); }
+
+    // Host only: opens the link, then sends one write over it (in TLS records when secure), see HostLink
+    void linkOpen();
+    void linkWrite(size_t size);
+
+protected:
+    size_t readable();
+
+    bool secure = false;
+    int transmit_size = 837; // TLS transmit buffer, plaintext and record overhead
+    bool in_flight = false;  // Data sent and not acknowledged yet
+    bool is_connected = false;
+    bool no_delay = false;
+    bool scripted = false;
+    bool answered = false;
+    bool close_at_end = true;
+    std::string request;
+    std::string answer;
+    size_t position = 0;
+};
+
+namespace BearSSL
+{
+    class Session
+    {
+    };
+    class X509List
+    {
+    };
+
+    class WiFiClientSecure : public WiFiClient
+    {
+    public:
+        WiFiClientSecure() { secure = true; }
+        void setInsecure() {}
+        void setSession(Session *) {}
+        void setTrustAnchors(const X509List *) {}
+        bool setCiphers(const uint16_t *ciphers, int count) { cipher_count = count; return ciphers != nullptr; }
+        bool setCiphers(const std::vector<uint16_t> &ciphers) { cipher_count = ciphers.size(); return true; }
+        bool setCiphersLessSecure() { return true; }
+        void setBufferSizes(int, int transmit) { transmit_size = transmit; }
+        bool probeMaxFragmentLength(const char *, uint16_t, uint16_t) { return true; }
+        void setSSLVersion(uint32_t, uint32_t) {}
+
+        int cipher_count = 0;
+    };
+}
+
+#define BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256 0xC02B
+#define BR_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256 0xC02F
+#define BR_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256 0xCCA9
+#define BR_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256 0xCCA8
+
+class WiFiClass
+{
+public:
+    int status() { return WL_CONNECTED; }
+    void begin(const char *, const char *) {}
+    int hostByName(const char *, IPAddress &ip) { ip = IPAddress(0x0100007F); return 1; }
+    int hostByName(const char *host, IPAddress &ip, uint32_t) { return hostByName(host, ip); }
+    int32_t RSSI() { return -60; }
+    void forceSleepWake() {}
+};
+extern WiFiClass WiFi;
+
+#endif
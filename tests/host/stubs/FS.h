@@ -0,0 +1,28 @@
+// FS.h
+//
+// Host stand-in for the flash file system: a File writes to a stdio FILE.
+
+#ifndef FS_h
+#define FS_h
+
+#include "Arduino.h"
+
+namespace fs
+{
+    class File : public Stream
+    {
+    public:
+        explicit File(FILE *file = nullptr) : file(file) {}
+        using Print::write;
+        size_t write(const uint8_t *buffer, size_t size) override { return file ? fwrite(buffer, 1, size, file) : 0; }
+        int available() override { return 0; }
+        int read() override { return -1; }
+        void flush() { if (file) fflush(file); }
+        explicit operator bool() const { return file != nullptr; }
+
+    private:
+        FILE *file;
+    };
+}
+
+#endif
@@ -0,0 +1,3 @@
+// HTTPClient.h
+
+#include "ESP8266HTTPClient.h"
@@ -0,0 +1,94 @@
+// HostNet.h
+//
+// The scripted network and clock behind the host stubs. Tests answer requests through host::handler, which
+// serves both HTTPClient (GET requests) and the raw clients (coalesced transport, poll, diagnostics), or
+// script the raw bytes of the next answer with host::serve(). host::link gives the link a round trip time,
+// a throughput and losses.
+
+#ifndef HostNet_h
+#define HostNet_h
+
+#include <functional>
+#include <map>
+#include <string>
+
+struct HostRequest
+{
+    std::string method;
+    std::string url; // Full URL for HTTPClient, request target for the raw clients
+    std::map<std::string, std::string> headers;
+    std::string body;
+};
+
+struct HostReply
+{
+    int code;
+    std::string body;
+    std::map<std::string, std::string> headers;
+    size_t dropAfter; // The connection drops after this many body bytes
+    int size;         // Content length announced, -1 for the body length
+    unsigned long latencyMs; // HTTPClient: the clock advances this much, a read timeout when over setTimeout()
+
+    HostReply(int code = 200, const std::string &body = "")
+        : code(code), body(body), dropAfter((size_t)-1), size(-1), latencyMs(0)
+    {
+    }
+};
+
+// Timing of the link between the device and the server. All zero, the default, makes connections and transfers
+// take no time. The clock advances by the TCP and TLS handshakes on connect, by the transfer of every write and
+// answer, and by the stalls of Nagle's algorithm: without setNoDelay(true), a segment smaller than the MSS waits
+// for the ACK of the data already sent, which the server delays as it has nothing to answer yet.
+struct HostLink
+{
+    unsigned long rttMs;          // Round trip time
+    unsigned long bytesPerSecond; // Throughput in each direction, 0 for no limit
+    unsigned lossPercent;         // Segments lost, each one costs rtoMs more
+    unsigned long rtoMs;          // Retransmission timeout
+    unsigned long tlsHandshakeMs; // Device CPU time of a TLS handshake, on top of its two round trips
+    unsigned long delayedAckMs;   // How long the server holds the ACK of a lone segment
+    unsigned mss;                 // TCP segment payload, 0 for 1460
+};
+
+namespace host
+{
+    // Answers every request, nullptr makes connections fail
+    extern std::function<HostReply(const HostRequest &)> handler;
+
+    // millis() and micros() return this clock, delay() advances it
+    extern unsigned long now;
+
+    // Everything printed to Serial
+    extern std::string serial;
+
+    // Raw clients: the next connection reads these bytes instead of asking the handler. Only `arrived` of them
+    // are readable (poll tests raise it step by step), and the connection closes once they are all read
+    // when closeAtEnd is set.
+    extern std::string wire;
+    extern size_t arrived;
+    extern bool closeAtEnd;
+
+    // Raw clients: bytes written by the last connection, in how many write() calls, and whether
+    // setNoDelay(true) was called on it while it was connected
+    extern std::string sent;
+    extern unsigned writes;
+    extern bool noDelay;
+
+    // Requests seen by HTTPClient and the raw clients
+    extern unsigned requests;
+
+    // Link timing, see HostLink
+    extern HostLink link;
+
+    // Last connection, HTTPClient included: TCP segments and TLS records sent, and the bytes they took on the
+    // link (TLS overhead included). Records are sealed for AES-128-GCM, 29 bytes of overhead each, and hold what
+    // fits in the transmit buffer given to setBufferSizes() (the ESP8266 core's 837 bytes by default).
+    extern unsigned segments;
+    extern unsigned records;
+    extern size_t wireBytes;
+
+    void serve(const std::string &bytes, bool close = true);
+    void reset();
+}
+
+#endif
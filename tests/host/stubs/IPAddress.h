@@ -0,0 +1,19 @@
+// IPAddress.h
+
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include "Arduino.h"
+
+class IPAddress
+{
+public:
+    IPAddress(uint32_t address = 0) : address(address) {}
+    operator uint32_t() const { return address; }
+    String toString() const { return String("127.0.0.1"); }
+
+private:
+    uint32_t address;
+};
+
+#endif
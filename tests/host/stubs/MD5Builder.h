@@ -0,0 +1,27 @@
+// MD5Builder.h
+//
+// Host stand-in for the core MD5Builder (RFC 1321), implemented in stubs.cpp.
+
+#ifndef MD5Builder_h
+#define MD5Builder_h
+
+#include "Arduino.h"
+
+class MD5Builder
+{
+public:
+    void begin();
+    void add(const uint8_t *data, uint16_t length);
+    void calculate();
+    String toString() const;
+
+private:
+    void transform(const uint8_t *block);
+
+    uint32_t state[4];
+    uint64_t total;
+    uint8_t buffer[64];
+    uint8_t digest[16];
+};
+
+#endif
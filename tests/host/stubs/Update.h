@@ -0,0 +1,3 @@
+// Update.h
+
+#include "Updater.h"
@@ -0,0 +1,3 @@
+// WiFi.h
+
+#include "ESP8266WiFi.h"
@@ -0,0 +1,3 @@
+// WiFiClientSecure.h
+
+#include "ESP8266WiFi.h"
@@ -0,0 +1,553 @@
+// stubs.cpp
+//
+// Globals of the host stubs and the scripted network behind WiFiClient and HTTPClient.
+
+#include "Arduino.h"
+#include "ESP8266HTTPClient.h"
+#include "MD5Builder.h"
+#include "Updater.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+UpdateClass Update;
+
+// State of the generator deciding which segments are lost, restarted by host::reset()
+static uint32_t lossState = 1;
+
+namespace host
+{
+    std::function<HostReply(const HostRequest &)> handler;
+    unsigned long now = 1000;
+    std::string serial;
+    std::string wire;
+    size_t arrived = (size_t)-1;
+    bool closeAtEnd = true;
+    std::string sent;
+    unsigned writes = 0;
+    bool noDelay = false;
+    unsigned requests = 0;
+    HostLink link = {};
+    unsigned segments = 0;
+    unsigned records = 0;
+    size_t wireBytes = 0;
+
+    void serve(const std::string &bytes, bool close)
+    {
+        wire = bytes;
+        arrived = (size_t)-1;
+        closeAtEnd = close;
+    }
+
+    void reset()
+    {
+        handler = nullptr;
+        serial.clear();
+        wire.clear();
+        arrived = (size_t)-1;
+        closeAtEnd = true;
+        sent.clear();
+        writes = 0;
+        noDelay = false;
+        requests = 0;
+        link = {};
+        segments = 0;
+        records = 0;
+        wireBytes = 0;
+        lossState = 1;
+    }
+}
+
+// Link model, see HostLink
+
+// Overhead of a TLS record sealed with AES-128-GCM: header, explicit nonce and tag
+#define HOST_TLS_RECORD_OVERHEAD 29
+// Bytes of a TLS handshake, most of them the server certificate chain
+#define HOST_TLS_HANDSHAKE_BYTES 3000
+
+static unsigned long transferMs(size_t bytes)
+{
+    return host::link.bytesPerSecond > 0 ? (unsigned long)(bytes * 1000ULL / host::link.bytesPerSecond) : 0;
+}
+
+static size_t linkMss()
+{
+    return host::link.mss > 0 ? host::link.mss : 1460;
+}
+
+// Transfer time of bytes and the retransmissions of the segments lost on the way
+static void linkTransfer(size_t bytes)
+{
+    size_t segments = (bytes + linkMss() - 1) / linkMss();
+    host::now += transferMs(bytes);
+    for (size_t i = 0; i < segments && host::link.lossPercent > 0; i++)
+    {
+        lossState = lossState * 1103515245 + 12345;
+        if ((lossState >> 16) % 100 < host::link.lossPercent)
+        {
+            host::now += host::link.rtoMs;
+        }
+    }
+}
+
+// One TCP write. With Nagle, a trailing segment smaller than the MSS is held until the data sent before it is
+// acknowledged: a round trip and the server's delayed ACK.
+static void linkSend(size_t bytes, bool noDelay, bool &inFlight)
+{
+    size_t segments = (bytes + linkMss() - 1) / linkMss();
+    if (!noDelay && bytes % linkMss() != 0 && (inFlight || segments > 1))
+    {
+        host::now += host::link.rttMs + host::link.delayedAckMs;
+    }
+    linkTransfer(bytes);
+    host::segments += segments;
+    host::wireBytes += bytes;
+    inFlight = true;
+}
+
+// The answer comes back a round trip after the request, once the server took latencyMs
+static void linkAnswer(size_t bytes, unsigned long latencyMs)
+{
+    host::now += host::link.rttMs + latencyMs;
+    linkTransfer(bytes);
+}
+
+void WiFiClient::linkOpen()
+{
+    in_flight = false;
+    host::segments = 0;
+    host::records = 0;
+    host::wireBytes = 0;
+
+    host::now += host::link.rttMs;
+    if (secure)
+    {
+        host::now += 2 * host::link.rttMs + host::link.tlsHandshakeMs;
+        linkTransfer(HOST_TLS_HANDSHAKE_BYTES);
+    }
+}
+
+void WiFiClient::linkWrite(size_t size)
+{
+    if (!secure)
+    {
+        linkSend(size, no_delay, in_flight);
+        return;
+    }
+
+    // BearSSL seals what fits in the transmit buffer as one record, and sends each record on its own
+    size_t capacity = transmit_size - HOST_TLS_RECORD_OVERHEAD;
+    while (size > 0)
+    {
+        size_t record = size < capacity ? size : capacity;
+        linkSend(record + HOST_TLS_RECORD_OVERHEAD, no_delay, in_flight);
+        host::records++;
+        size -= record;
+    }
+}
+
+unsigned long millis()
+{
+    return host::now;
+}
+
+unsigned long micros()
+{
+    return host::now * 1000;
+}
+
+void delay(unsigned long ms)
+{
+    host::now += ms;
+}
+
+void yield()
+{
+}
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer)
+{
+    sprintf(buffer, "%*.*f", width, precision, value);
+    return buffer;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    host::serial.append((const char *)buffer, size);
+    return size;
+}
+
+static const char *reasonPhrase(int code)
+{
+    switch (code)
+    {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 429: return "Too Many Requests";
+    default: return "Status";
+    }
+}
+
+static const std::string *findHeader(const std::map<std::string, std::string> &headers, const char *name)
+{
+    for (const auto &header : headers)
+    {
+        if (strcasecmp(header.first.c_str(), name) == 0)
+        {
+            return &header.second;
+        }
+    }
+    return nullptr;
+}
+
+// WiFiClient
+
+int WiFiClient::connect(const char *, uint16_t)
+{
+    is_connected = false;
+    no_delay = false;
+    request.clear();
+    answer.clear();
+    position = 0;
+    host::sent.clear();
+    host::writes = 0;
+    host::noDelay = false;
+
+    scripted = !host::wire.empty();
+    if (scripted)
+    {
+        answer.swap(host::wire);
+        close_at_end = host::closeAtEnd;
+        host::requests++;
+    }
+    else if (!host::handler)
+    {
+        return 0;
+    }
+    answered = scripted;
+    is_connected = true;
+    linkOpen();
+    return 1;
+}
+
+int WiFiClient::connect(IPAddress, uint16_t port)
+{
+    return connect("", port);
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size)
+{
+    if (!is_connected)
+    {
+        return 0;
+    }
+    request.append((const char *)buffer, size);
+    host::sent.append((const char *)buffer, size);
+    host::writes++;
+    linkWrite(size);
+    return size;
+}
+
+// Once the whole request is written, builds the answer from host::handler
+size_t WiFiClient::readable()
+{
+    if (!answered)
+    {
+        size_t headEnd = request.find("\r\n\r\n");
+        if (headEnd == std::string::npos)
+        {
+            return 0;
+        }
+
+        HostRequest parsed;
+        size_t lineEnd = request.find("\r\n");
+        size_t space = request.find(' ');
+        parsed.method = request.substr(0, space);
+        parsed.url = request.substr(space + 1, request.rfind(' ', lineEnd) - space - 1);
+        for (size_t line = lineEnd + 2; line < headEnd;)
+        {
+            size_t end = request.find("\r\n", line);
+            size_t colon = request.find(':', line);
+            parsed.headers[request.substr(line, colon - line)] = request.substr(colon + 2, end - colon - 2);
+            line = end + 2;
+        }
+        const std::string *length = findHeader(parsed.headers, "Content-Length");
+        size_t bodyLength = length != nullptr ? strtoul(length->c_str(), nullptr, 10) : 0;
+        if (request.size() < headEnd + 4 + bodyLength)
+        {
+            return 0;
+        }
+        parsed.body = request.substr(headEnd + 4, bodyLength);
+
+        host::requests++;
+        answered = true;
+        close_at_end = true;
+        HostReply reply = host::handler(parsed);
+        if (reply.code > 0)
+        {
+            linkAnswer(reply.body.size(), reply.latencyMs);
+            char status[64];
+            snprintf(status, sizeof(status), "HTTP/1.1 %d %s\r\n", reply.code, reasonPhrase(reply.code));
+            answer = status;
+            for (const auto &header : reply.headers)
+            {
+                answer += header.first + ": " + header.second + "\r\n";
+            }
+            answer += "Content-Length: " + std::to_string(reply.size >= 0 ? (size_t)reply.size : reply.body.size());
+            answer += "\r\nConnection: close\r\n\r\n";
+            answer += reply.body.substr(0, reply.dropAfter);
+        }
+    }
+
+    size_t limit = answer.size() < host::arrived || !scripted ? answer.size() : host::arrived;
+    return limit - position;
+}
+
+int WiFiClient::available()
+{
+    return is_connected ? (int)readable() : 0;
+}
+
+int WiFiClient::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size)
+{
+    size_t count = is_connected ? readable() : 0;
+    if (count == 0)
+    {
+        return -1;
+    }
+    count = count < size ? count : size;
+    memcpy(buffer, answer.data() + position, count);
+    position += count;
+    return (int)count;
+}
+
+int WiFiClient::peek()
+{
+    return is_connected && readable() > 0 ? (uint8_t)answer[position] : -1;
+}
+
+uint8_t WiFiClient::connected()
+{
+    if (!is_connected)
+    {
+        return 0;
+    }
+    // Closed by the server once everything it sends was read
+    bool allSent = answered && (!scripted || host::arrived >= answer.size());
+    return readable() > 0 || !(allSent && close_at_end);
+}
+
+void WiFiClient::setNoDelay(bool noDelay)
+{
+    no_delay = noDelay;
+    if (is_connected)
+    {
+        host::noDelay = noDelay;
+    }
+}
+
+// HTTPClient
+
+bool HTTPClient::begin(WiFiClient &client, const String &url)
+{
+    begun = url.startsWith("http://") || url.startsWith("https://");
+    this->client = &client;
+    request = HostRequest();
+    request.url = url.s;
+    reply = HostReply();
+    body.data.clear();
+    body.limit = 0;
+    return begun;
+}
+
+void HTTPClient::addHeader(const String &name, const String &value, bool, bool)
+{
+    request.headers[name.s] = value.s;
+}
+
+void HTTPClient::collectHeaders(const char *names[], const size_t count)
+{
+    collected.assign(names, names + count);
+}
+
+int HTTPClient::sendRequest(const char *method, const String &payload)
+{
+    if (!begun || !host::handler)
+    {
+        return HTTPC_ERROR_CONNECTION_FAILED;
+    }
+    request.method = method;
+    request.body = payload.s;
+    host::requests++;
+
+    // Like the core's HTTPClient, the head is one write and the payload another, without setNoDelay()
+    size_t head = strlen(method) + request.url.size() + 100;
+    for (const auto &header : request.headers)
+    {
+        head += header.first.size() + header.second.size() + 4;
+    }
+    client->linkOpen();
+    client->linkWrite(head);
+    if (!request.body.empty())
+    {
+        client->linkWrite(request.body.size());
+    }
+
+    reply = host::handler(request);
+    if (reply.latencyMs > timeout_ms)
+    {
+        host::now += host::link.rttMs + timeout_ms;
+        reply = HostReply();
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    linkAnswer(reply.body.size(), reply.latencyMs);
+    body.data = reply.body;
+    body.position = 0;
+    body.limit = reply.body.size() < reply.dropAfter ? reply.body.size() : reply.dropAfter;
+    return reply.code;
+}
+
+String HTTPClient::header(size_t i)
+{
+    const std::string *value = i < collected.size() ? findHeader(reply.headers, collected[i].c_str()) : nullptr;
+    return value != nullptr ? String(*value) : String();
+}
+
+String HTTPClient::header(const char *name)
+{
+    const std::string *value = findHeader(reply.headers, name);
+    return value != nullptr ? String(*value) : String();
+}
+
+String HTTPClient::getString()
+{
+    return String(body.data.substr(0, body.limit));
+}
+
+int HTTPClient::Body::available()
+{
+    return (int)(limit - position);
+}
+
+int HTTPClient::Body::read()
+{
+    return position < limit ? (uint8_t)data[position++] : -1;
+}
+
+int HTTPClient::Body::read(uint8_t *buffer, size_t size)
+{
+    size = size < limit - position ? size : limit - position;
+    memcpy(buffer, data.data() + position, size);
+    position += size;
+    return (int)size;
+}
+
+// MD5Builder, after RFC 1321
+
+static const uint32_t md5Sines[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+static const uint8_t md5Shifts[16] = {7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21};
+
+void MD5Builder::begin()
+{
+    state[0] = 0x67452301;
+    state[1] = 0xefcdab89;
+    state[2] = 0x98badcfe;
+    state[3] = 0x10325476;
+    total = 0;
+}
+
+void MD5Builder::transform(const uint8_t *block)
+{
+    uint32_t words[16];
+    for (int i = 0; i < 16; i++)
+    {
+        words[i] = block[i * 4] | (block[i * 4 + 1] << 8) | (block[i * 4 + 2] << 16) | ((uint32_t)block[i * 4 + 3] << 24);
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    for (int i = 0; i < 64; i++)
+    {
+        uint32_t f;
+        int g;
+        switch (i / 16)
+        {
+        case 0: f = (b & c) | (~b & d); g = i; break;
+        case 1: f = (d & b) | (~d & c); g = (5 * i + 1) % 16; break;
+        case 2: f = b ^ c ^ d; g = (3 * i + 5) % 16; break;
+        default: f = c ^ (b | ~d); g = (7 * i) % 16; break;
+        }
+        uint32_t rotated = a + f + md5Sines[i] + words[g];
+        uint8_t shift = md5Shifts[(i / 16) * 4 + i % 4];
+        a = d;
+        d = c;
+        c = b;
+        b += (rotated << shift) | (rotated >> (32 - shift));
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+}
+
+void MD5Builder::add(const uint8_t *data, uint16_t length)
+{
+    for (uint16_t i = 0; i < length; i++)
+    {
+        buffer[total++ % 64] = data[i];
+        if (total % 64 == 0)
+        {
+            transform(buffer);
+        }
+    }
+}
+
+void MD5Builder::calculate()
+{
+    uint64_t bits = total * 8;
+    uint8_t pad = 0x80;
+    add(&pad, 1);
+    pad = 0;
+    while (total % 64 != 56)
+    {
+        add(&pad, 1);
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        uint8_t byte = (uint8_t)(bits >> (8 * i));
+        add(&byte, 1);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        digest[i] = (uint8_t)(state[i / 4] >> (8 * (i % 4)));
+    }
+}
+
+String MD5Builder::toString() const
+{
+    char hex[33];
+    for (int i = 0; i < 16; i++)
+    {
+        sprintf(hex + 2 * i, "%02x", digest[i]);
+    }
+    return String(hex);
+}
@@ -0,0 +1,145 @@
+// Host test of the auth token refresh schedule
+
+#include "PocketbaseExtended.h"
+#include "host_test.h"
+
+#if PB_ENABLE_AUTH
+
+// 1994-11-06 08:49:37 UTC, the Date of every response
+#define SERVER_NOW 784111777UL
+
+static std::string token;
+static unsigned refreshes = 0;
+
+static std::string base64Url(const std::string &text)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::string out;
+    uint32_t bits = 0;
+    int count = 0;
+    for (unsigned char c : text)
+    {
+        bits = (bits << 8) | c;
+        count += 8;
+        while (count >= 6)
+        {
+            count -= 6;
+            out += alphabet[(bits >> count) & 0x3F];
+        }
+    }
+    if (count > 0)
+    {
+        out += alphabet[(bits << (6 - count)) & 0x3F];
+    }
+    return out;
+}
+
+static std::string jwt(const std::string &claims)
+{
+    return "eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9." + base64Url(claims) + ".c2lnbmF0dXJl";
+}
+
+static HostReply answer(const HostRequest &request)
+{
+    HostReply reply(200, "{}");
+    if (request.url.find("/auth-with-password") != std::string::npos ||
+        request.url.find("/auth-refresh") != std::string::npos)
+    {
+        refreshes += request.url.find("/auth-refresh") != std::string::npos;
+        reply.body = "{\"token\":\"" + token + "\",\"record\":{\"id\":\"abcdefghijklmno\"}}";
+    }
+    reply.headers["Date"] = "Sun, 06 Nov 1994 08:49:37 GMT";
+    return reply;
+}
+
+// Record requests are refused with 401, the refresh is answered with refreshStatus and refreshBody
+static int refreshStatus;
+static std::string refreshBody;
+
+static HostReply revoked(const HostRequest &request)
+{
+    HostReply reply(401, "{\"code\":401,\"message\":\"The request requires valid record authorization token.\"}");
+    reply.headers["Date"] = "Sun, 06 Nov 1994 08:49:37 GMT";
+    if (request.url.find("/auth-refresh") != std::string::npos)
+    {
+        reply = HostReply(refreshStatus, refreshBody);
+        reply.headers["Date"] = "Sun, 06 Nov 1994 08:50:00 GMT";
+    }
+    return reply;
+}
+
+// A 401 whose refresh fails is returned as it came, with the headers of the 401
+static void checkFailedRefresh(PocketbaseExtended &pb, int status, const char *body)
+{
+    refreshStatus = status;
+    refreshBody = body;
+    token = jwt("{\"exp\":" + std::to_string(SERVER_NOW + 5000) + ",\"iat\":" + std::to_string(SERVER_NOW) + "}");
+    pb.setAuthToken("users", token.c_str());
+    host::now += 1000;
+
+    host::handler = revoked;
+    PocketbaseResponse response = pb.getOne("abcdefghijklmno", nullptr, nullptr);
+    host::handler = answer;
+    CHECK(response.statusCode() == 401);
+    CHECK(!response.ok());
+    CHECK(pb.lastStatusCode() == 401);
+#if PB_ENABLE_RESPONSE_HEADERS
+    CHECK(strcmp(pb.lastHeaders().date, "Sun, 06 Nov 1994 08:49:37 GMT") == 0);
+#endif
+}
+
+// Lets time pass, then tells whether the next request refreshed the token first
+static bool refreshedAfter(PocketbaseExtended &pb, unsigned long ms)
+{
+    host::now += ms;
+    unsigned before = refreshes;
+    pb.getOne("abcdefghijklmno", nullptr, nullptr);
+    return refreshes > before;
+}
+
+int main()
+{
+    host::reset();
+    host::handler = answer;
+    PocketbaseExtended pb("http://pb.local/");
+    pb.collection("readings");
+
+    // PocketBase tokens only carry exp: 1000 s left at the server time, refreshed after 80% of it
+    token = jwt("{\"collectionId\":\"_pb_users_auth_\",\"exp\":" + std::to_string(SERVER_NOW + 1000) + ",\"type\":\"auth\"}");
+    CHECK(pb.authWithPassword("users", "device", "secret").ok());
+    CHECK(pb.authToken() == String(token));
+    CHECK(!refreshedAfter(pb, 799000));
+    CHECK(refreshedAfter(pb, 2000));
+    // Neither the login nor the refresh response is logged, they hold the token
+#if PB_ENABLE_LOG
+    CHECK(host::serial.find("/auth-refresh") != std::string::npos);
+#endif
+    CHECK(host::serial.find(token) == std::string::npos);
+
+    // With iat, the lifetime comes from the token alone
+    pb.clearAuth();
+    token = jwt("{\"exp\":" + std::to_string(SERVER_NOW + 5000) + ",\"iat\":" + std::to_string(SERVER_NOW + 4000) + "}");
+    pb.setAuthToken("users", token.c_str());
+    CHECK(!refreshedAfter(pb, 799000));
+    CHECK(refreshedAfter(pb, 2000));
+
+    // Without exp the token is never refreshed
+    token = jwt("{\"id\":\"abcdefghijklmno\"}");
+    pb.setAuthToken("users", token.c_str());
+    CHECK(!refreshedAfter(pb, 1000000000));
+
+    // A refresh answered without a token does not turn the 401 into a success, nor a transport error into -1
+    checkFailedRefresh(pb, 200, "{}");
+    checkFailedRefresh(pb, HTTPC_ERROR_CONNECTION_LOST, "");
+
+    return testsPassed("auth");
+}
+
+#else
+
+int main()
+{
+    return testsPassed("auth (disabled)");
+}
+
+#endif
@@ -0,0 +1,53 @@
+// Host test of the diagnostics report
+
+#include "PocketbaseExtended.h"
+#include "host_test.h"
+#include <vector>
+
+#if PB_ENABLE_DIAGNOSTICS
+
+int main()
+{
+    host::reset();
+    PocketbaseExtended pb("http://pb.example.com/pb");
+
+    PocketbaseDiagnostics diagnostics = {12, 40, 900, -1, 55, 210, 18000, 85714, 40000, 39000, 31000};
+    String json = pb.diagnosticsToJson(diagnostics);
+    CHECK(json == "{\"host\":\"pb.example.com\",\"dnsMs\":12,\"tcpConnectMs\":40,\"tlsFullMs\":900,\"tlsResumedMs\":-1,"
+                  "\"ttfbMs\":55,\"listMs\":210,\"listBytes\":18000,\"listBytesPerSec\":85714,"
+                  "\"heapBefore\":40000,\"heapAfter\":39000,\"minFreeHeap\":31000}");
+
+    // The timed requests carry the auth token like the others, with a host the records need one
+    pb.collection("readings");
+#if PB_ENABLE_AUTH
+    pb.setAuthToken("users", "token-abc");
+#endif
+    std::vector<HostRequest> seen;
+    host::handler = [&](const HostRequest &request)
+    {
+        seen.push_back(request);
+        return HostReply(200, "{\"items\":[]}");
+    };
+    diagnostics = pb.runDiagnostics("rec1", "50");
+    CHECK(seen.size() == 2);
+    CHECK(diagnostics.ttfbMs >= 0 && diagnostics.listBytes > 0);
+    if (seen.size() == 2)
+    {
+        CHECK(seen[0].url == "/pb/api/collections/readings/records/rec1");
+        CHECK(seen[1].url == "/pb/api/collections/readings/records/?skipTotal=1&perPage=50");
+#if PB_ENABLE_AUTH
+        CHECK(seen[0].headers["Authorization"] == "token-abc" && seen[1].headers["Authorization"] == "token-abc");
+#endif
+    }
+
+    return testsPassed("diagnostics");
+}
+
+#else
+
+int main()
+{
+    return testsPassed("diagnostics (disabled)");
+}
+
+#endif
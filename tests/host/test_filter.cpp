@@ -0,0 +1,94 @@
+// Host test of PocketbaseReportFilter
+
+#include "PocketbaseFilter.h"
+#include "host_test.h"
+#include <vector>
+
+struct Point
+{
+    uint32_t at;
+    float value;
+};
+
+// Value of the line through the uploaded points at a given time
+static float interpolate(const std::vector<Point> &points, uint32_t at)
+{
+    for (size_t i = 1; i < points.size(); i++)
+    {
+        if (points[i].at >= at)
+        {
+            float f = (float)(at - points[i - 1].at) / (points[i].at - points[i - 1].at);
+            return points[i - 1].value + f * (points[i].value - points[i - 1].value);
+        }
+    }
+    return points.back().value;
+}
+
+int main()
+{
+    static const PocketbaseFilterRule rules[] = {
+        {"temperature", 0, 0.2f, 0, 600000},
+        {"humidity", 1.0f, 0, 5000, 0},
+    };
+
+    // A noisy, drifting signal with a step: the uploaded points stay close to every offered one
+    PocketbaseReportFilter filter(rules, 2);
+    std::vector<Point> offered, sent;
+    srand(1);
+    for (int i = 0; i < 20000; i++)
+    {
+        uint32_t at = (i + 1) * 1000;
+        float temperature = 20 + 0.0005f * i + 2 * sinf(i / 500.0f) + (i > 12000 ? 5 : 0) + (rand() % 100 - 50) / 1000.0f;
+        float values[] = {temperature, 50 + 10 * sinf(i / 3000.0f)};
+        offered.push_back({at, temperature});
+
+        PocketbaseReport report = filter.offer("room", values, at);
+        if (report == PB_REPORT_CURRENT)
+        {
+            sent.push_back({at, temperature});
+        }
+        else if (report == PB_REPORT_PREVIOUS)
+        {
+            CHECK(sent.empty() || filter.previousAt() > sent.back().at);
+            sent.push_back({filter.previousAt(), filter.previous()[0]});
+        }
+    }
+    sent.push_back(offered.back());
+
+    float worst = 0;
+    for (const Point &point : offered)
+    {
+        worst = fmaxf(worst, fabsf(interpolate(sent, point.at) - point.value));
+    }
+    // The swinging door keeps within twice its deviation
+    CHECK(worst <= 2 * rules[0].compression);
+    CHECK(filter.stats().sent < filter.stats().offered / 10);
+    CHECK(filter.stats().sent + filter.stats().suppressed == filter.stats().offered);
+
+    // A flat signal only sends the first record and the heartbeats
+    PocketbaseReportFilter flat(rules, 2);
+    float steady[] = {20, 50};
+    for (int i = 0; i < 3600; i++)
+    {
+        flat.offer("flat", steady, i * 1000);
+    }
+    CHECK(flat.stats().heartbeats == 5);
+    CHECK(flat.stats().sent == 6);
+
+    // The least recently offered series is evicted for a new one
+    char name[8];
+    for (int i = 0; i < PB_FILTER_SERIES + 4; i++)
+    {
+        snprintf(name, sizeof(name), "s%d", i);
+        flat.offer(name, steady, 4000000 + i);
+    }
+    CHECK(flat.stats().evicted == 5);
+
+    // Becoming NaN, and ceasing to be, is significant
+    float missing[] = {NAN, 50};
+    CHECK(flat.offer("s11", missing, 4000100) == PB_REPORT_CURRENT);
+    CHECK(flat.offer("s11", missing, 4000200) == PB_REPORT_SUPPRESS);
+    CHECK(flat.offer("s11", steady, 4000300) == PB_REPORT_CURRENT);
+
+    return testsPassed("filter");
+}
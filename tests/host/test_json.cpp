@@ -0,0 +1,71 @@
+// Host test of PocketbaseJsonWriter and the number parsers
+
+#include "PocketbaseJson.h"
+#include "host_test.h"
+
+static String write(float value)
+{
+    String out;
+    PocketbaseJsonWriter json(out);
+    json.value(value);
+    return out;
+}
+
+int main()
+{
+    String out;
+    PocketbaseJsonWriter json(out);
+    json.beginObject().field("a", 21.5f).field("b", -3).field("c", "q\"\\\n").field("d", true).field("e", NAN);
+    json.key("f").beginArray().value(1).value(2).endArray().endObject();
+    CHECK(out == "{\"a\":21.5,\"b\":-3,\"c\":\"q\\\"\\\\\\u000a\",\"d\":true,\"e\":null,\"f\":[1,2]}");
+
+    CHECK(write(0.1f) == "0.1");
+    CHECK(write(1013.25f) == "1013.25");
+    CHECK(write(0.0f) == "0");
+
+    // Floats are written with at least PB_JSON_FLOAT_DIGITS significant digits, as close as printf("%.7g")
+    srand(1);
+    int mismatches = 0;
+    char text[64];
+    for (int i = 0; i < 100000; i++)
+    {
+        float value = (rand() / (float)RAND_MAX - 0.5f) * powf(10, rand() % 16 - 4);
+        snprintf(text, sizeof(text), "%.7g", (double)value);
+        double error = fabs(strtod(write(value).c_str(), nullptr) - value);
+        mismatches += error > fabs(strtod(text, nullptr) - value) * 1.000001;
+    }
+    CHECK(mismatches == 0);
+
+    // Doubles read back exactly, in as few of 15 to 17 digits as that takes
+    String doubles;
+    PocketbaseJsonWriter doubleJson(doubles);
+    doubleJson.beginArray().value(0.1).value(1700000000.123).value(-2.5e-7).value(1.0 / 3).endArray();
+    CHECK(doubles == "[0.1,1700000000.123,-2.5e-07,0.33333333333333331]");
+    mismatches = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        double value = (rand() / (double)RAND_MAX - 0.5) * pow(10, rand() % 40 - 20);
+        String one;
+        PocketbaseJsonWriter(one).value(value);
+        mismatches += strtod(one.c_str(), nullptr) != value;
+    }
+    CHECK(mismatches == 0);
+
+    float parsed;
+    CHECK(pocketbaseParseFloat("21.5", parsed) != nullptr && parsed == 21.5f);
+    CHECK(pocketbaseParseFloat("-2.5E-3", parsed) != nullptr && parsed == strtof("-2.5E-3", nullptr));
+    CHECK(pocketbaseParseFloat("abc", parsed) == nullptr);
+    int32_t integer;
+    CHECK(pocketbaseParseInt("-2147483648", integer) != nullptr && integer == INT32_MIN);
+
+    // Same result as strtof on the decimals PocketBase sends
+    mismatches = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        snprintf(text, sizeof(text), "%.*f", rand() % 8, (rand() / (double)RAND_MAX - 0.5) * pow(10, rand() % 7));
+        mismatches += pocketbaseParseFloat(text, parsed) == nullptr || parsed != strtof(text, nullptr);
+    }
+    CHECK(mismatches == 0);
+
+    return testsPassed("json");
+}
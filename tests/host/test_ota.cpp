@@ -0,0 +1,134 @@
+// Host test of updateFirmware(): downloads dropped in the middle are resumed with Range requests
+
+#include "PocketbaseExtended.h"
+#include "host_test.h"
+
+#if PB_ENABLE_OTA
+#include <MD5Builder.h>
+#include <vector>
+
+static std::string image;
+static std::string md5;
+static std::vector<size_t> drops; // Body bytes sent by each download before it drops
+static bool ignoreRange = false;
+static int downloads = 0;
+
+struct MemorySink : PocketbaseFirmwareSink
+{
+    std::string written;
+    bool ended = false;
+    bool aborted = false;
+
+    bool begin(size_t, const char *) override { return true; }
+    bool write(const uint8_t *data, size_t length) override { written.append((const char *)data, length); return true; }
+    bool end() override { ended = true; return true; }
+    void abort() override { aborted = true; }
+};
+
+static HostReply answer(const HostRequest &request)
+{
+    host::now += 100;
+    if (request.url.find("/records") != std::string::npos)
+    {
+        return HostReply(200, "{\"page\":1,\"items\":[{\"id\":\"abcdefghijklmno\",\"version\":\"1.2.0\","
+                              "\"file\":\"fw_x1.bin\",\"size\":" + std::to_string(image.size()) +
+                              ",\"md5\":\"" + md5 + "\"}]}");
+    }
+
+    downloads++;
+    CHECK(request.url == "http://pb.local/api/files/firmware/abcdefghijklmno/fw_x1.bin");
+    size_t from = 0;
+    auto range = request.headers.find("Range");
+    if (range != request.headers.end() && !ignoreRange)
+    {
+        from = strtoul(range->second.c_str() + 6, nullptr, 10);
+    }
+
+    HostReply reply(from > 0 ? 206 : 200, image.substr(from));
+    if (!drops.empty())
+    {
+        reply.dropAfter = drops.front();
+        drops.erase(drops.begin());
+    }
+    return reply;
+}
+
+int main()
+{
+    MD5Builder check;
+    check.begin();
+    check.add((const uint8_t *)"abc", 3);
+    check.calculate();
+    CHECK(check.toString() == "900150983cd24fb0d6963f7d28e17f72");
+
+    srand(7);
+    for (int i = 0; i < 100000; i++)
+    {
+        image += (char)(rand() & 0xFF);
+    }
+    MD5Builder hash;
+    hash.begin();
+    for (size_t i = 0; i < image.size(); i += 1000)
+    {
+        hash.add((const uint8_t *)image.data() + i, 1000);
+    }
+    hash.calculate();
+    md5 = hash.toString().c_str();
+
+    host::reset();
+    host::handler = answer;
+    PocketbaseExtended pb("http://pb.local/");
+    pb.collection("firmware");
+
+    // Two drops, resumed where they stopped
+    {
+        MemorySink sink;
+        drops = {30000, 50000};
+        CHECK(pb.updateFirmware(sink, "1.1.0") == PB_OTA_UPDATED);
+        CHECK(sink.written == image && sink.ended && downloads == 3);
+    }
+
+    {
+        MemorySink sink;
+        CHECK(pb.updateFirmware(sink, "1.2.0") == PB_OTA_UP_TO_DATE);
+        CHECK(sink.written.empty());
+    }
+
+    // A server ignoring Range sends the whole image again, what was written is skipped
+    {
+        MemorySink sink;
+        downloads = 0;
+        ignoreRange = true;
+        drops = {40000};
+        CHECK(pb.updateFirmware(sink, "1.1.0") == PB_OTA_UPDATED);
+        CHECK(sink.written == image && downloads == 2);
+        ignoreRange = false;
+    }
+
+    // Nothing is committed when the MD5 does not match
+    {
+        MemorySink sink;
+        md5[0] = md5[0] == '0' ? '1' : '0';
+        CHECK(pb.updateFirmware(sink, "1.1.0") == PB_OTA_VERIFY_FAILED);
+        CHECK(sink.aborted && !sink.ended);
+    }
+
+    // Gives up after PB_OTA_ATTEMPTS drops
+    {
+        MemorySink sink;
+        drops = std::vector<size_t>(PB_OTA_ATTEMPTS, 1);
+        CHECK(pb.updateFirmware(sink, "1.1.0") == PB_OTA_DOWNLOAD_FAILED);
+        CHECK(sink.aborted);
+    }
+
+    return testsPassed("ota");
+}
+
+#else
+
+int main()
+{
+    return testsPassed("ota (disabled)");
+}
+
+#endif
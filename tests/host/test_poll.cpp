@@ -0,0 +1,96 @@
+// Host test of beginGetList()/poll(): responses arrive a few bytes at a time, and no poll() reads more than
+// its byte budget
+
+#include "PocketbaseExtended.h"
+#include "host_test.h"
+
+#if PB_ENABLE_POLL
+
+// Runs one request, step bytes arriving before every poll(). Returns the number of poll() calls.
+static int run(PocketbaseExtended &pb, const std::string &wire, size_t step, bool close, PocketbaseResponse &response)
+{
+    host::serve(wire, close);
+    host::arrived = 0;
+    if (!pb.beginGetList("1", "500", nullptr, "a = 'b c'", nullptr, nullptr, nullptr))
+    {
+        response = pb.takeResponse();
+        return 0;
+    }
+
+    int polls = 0;
+    size_t received = 0;
+    PocketbasePollStatus status;
+    do
+    {
+        host::arrived += step;
+        host::now += 1 + polls % 3;
+        status = pb.poll();
+        polls++;
+
+        size_t total = pb.pollStats().bytes;
+        CHECK(total - received <= PB_POLL_BUDGET_BYTES);
+        received = total;
+    } while (status == PB_POLL_PENDING && polls < 100000);
+
+    response = pb.takeResponse();
+    return polls;
+}
+
+int main()
+{
+    std::string body;
+    for (int i = 0; i < 2000; i++)
+    {
+        body += "{\"id\":\"" + std::to_string(i) + "\"},";
+    }
+
+    PocketbaseExtended pb("http://pb.local:8090/");
+    pb.collection("things");
+    PocketbaseResponse response;
+
+    // Chunked
+    std::string chunked = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+    for (size_t i = 0; i < body.size(); i += 700)
+    {
+        std::string chunk = body.substr(i, 700);
+        char size[16];
+        snprintf(size, sizeof(size), "%zx\r\n", chunk.size());
+        chunked += size + chunk + "\r\n";
+    }
+    chunked += "0\r\n\r\n";
+    int polls = run(pb, chunked, 3000, false, response);
+    CHECK(response.statusCode() == 200 && response.body() == String(body));
+    CHECK(polls >= (int)(chunked.size() / PB_POLL_BUDGET_BYTES));
+    CHECK(host::sent.rfind("GET /api/collections/things/records/?page=1&perPage=500&filter", 0) == 0);
+    CHECK(host::sent.find("filter=a%20%3D%20%27b%20c%27") != std::string::npos);
+    CHECK(host::noDelay);
+
+    // Content-Length, the status and header lines split over many polls
+    std::string sized = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    run(pb, sized, 7, false, response);
+    CHECK(response.statusCode() == 200 && response.body() == String(body));
+
+    // Body until the server closes
+    run(pb, "HTTP/1.0 404 Not Found\r\n\r\n{\"x\":1}", 5000, true, response);
+    CHECK(response.statusCode() == 404 && response.body() == "{\"x\":1}");
+
+    // Dropped in the middle of the body
+    run(pb, sized.substr(0, 5000), 2000, true, response);
+    CHECK(response.statusCode() == HTTPC_ERROR_CONNECTION_LOST);
+    CHECK(pb.poll() == PB_POLL_IDLE);
+
+    // Empty body
+    run(pb, "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n", 100, false, response);
+    CHECK(response.statusCode() == 204 && response.length() == 0);
+
+    return testsPassed("poll");
+}
+
+#else
+
+int main()
+{
+    return testsPassed("poll (disabled)");
+}
+
+#endif
@@ -0,0 +1,163 @@
+// Host test of reconcile() against a fake server answering the pbext digest hook and the list API
+
+#include "PocketbaseExtended.h"
+#include "host_test.h"
+
+#if PB_ENABLE_RECONCILE
+#include <set>
+#include <vector>
+
+static std::set<std::string> server;
+static std::set<std::string> deleted, missing;
+static size_t bytes = 0;
+
+static uint32_t fnv1a(const std::string &id)
+{
+    uint32_t hash = 0x811C9DC5UL;
+    for (char c : id)
+    {
+        hash = (hash ^ (uint8_t)c) * 0x01000193UL;
+    }
+    return hash;
+}
+
+// Value of a "id <op> '<id>'" term of a filter
+static std::string bound(const std::string &filter, const char *term)
+{
+    size_t at = filter.find(term);
+    return at == std::string::npos ? "" : filter.substr(filter.find('\'', at) + 1, 15);
+}
+
+static HostReply answer(const HostRequest &request)
+{
+    host::now += 100; // Keeps within the default rate limit
+    std::string body;
+    if (request.url.find("/pbext/digest/") != std::string::npos)
+    {
+        // Count and xor of the id hashes of each range of 3 characters prefixes (base 36)
+        long ranges = atol(queryParam(request.url, "ranges").c_str());
+        long low = atol(queryParam(request.url, "low").c_str());
+        long high = atol(queryParam(request.url, "high").c_str());
+        std::vector<std::pair<uint32_t, uint32_t>> items(ranges);
+        for (const std::string &id : server)
+        {
+            long prefix = strtol(id.substr(0, 3).c_str(), nullptr, 36);
+            if (prefix >= low && prefix < high)
+            {
+                auto &item = items[(prefix - low) * ranges / (high - low)];
+                item.first++;
+                item.second ^= fnv1a(id);
+            }
+        }
+        body = "{\"ranges\":" + std::to_string(ranges) + ",\"items\":[";
+        for (long i = 0; i < ranges; i++)
+        {
+            body += (i > 0 ? ",[" : "[") + std::to_string(items[i].first) + "," + std::to_string(items[i].second) + "]";
+        }
+        body += "]}";
+    }
+    else
+    {
+        std::string filter = queryParam(request.url, "filter");
+        std::string low = bound(filter, "id >= "), high = bound(filter, "id < "), after = bound(filter, "id > ");
+        int perPage = atoi(queryParam(request.url, "perPage").c_str());
+        body = "{\"items\":[";
+        int listed = 0;
+        for (auto id = server.lower_bound(low); id != server.end() && listed < perPage; ++id)
+        {
+            if (!high.empty() && *id >= high)
+            {
+                break;
+            }
+            if (*id > after)
+            {
+                body += (listed++ > 0 ? ",{\"id\":\"" : "{\"id\":\"") + *id + "\"}";
+            }
+        }
+        body += "]}";
+    }
+    bytes += body.size();
+    return HostReply(200, body);
+}
+
+static void difference(const PocketbaseRecordId &id, bool isDeleted, void *)
+{
+    (isDeleted ? deleted : missing).insert(id.toString().c_str());
+}
+
+static std::string randomId()
+{
+    std::string id;
+    for (int i = 0; i < 15; i++)
+    {
+        id += "0123456789abcdefghijklmnopqrstuvwxyz"[rand() % 36];
+    }
+    return id;
+}
+
+int main()
+{
+    const int count = 20000;
+    srand(3);
+    std::vector<std::string> ids;
+    for (int i = 0; i < count; i++)
+    {
+        ids.push_back(randomId());
+        server.insert(ids.back());
+    }
+    std::vector<PocketbaseRecordId> local;
+    for (const std::string &id : server)
+    {
+        local.emplace_back(id.c_str());
+    }
+
+    std::set<std::string> expectedDeleted, expectedMissing;
+    for (int i = 0; i < 30; i++)
+    {
+        std::string id = ids[rand() % count];
+        if (server.erase(id))
+        {
+            expectedDeleted.insert(id);
+        }
+    }
+    for (int i = 0; i < 5; i++)
+    {
+        std::string id = randomId();
+        expectedMissing.insert(id);
+        server.insert(id);
+    }
+
+    host::reset();
+    host::handler = answer;
+    PocketbaseExtended pb("http://pb.local/");
+    pb.collection("readings");
+
+    PocketbaseReconcileResult result = pb.reconcile(local.data(), local.size(), difference, nullptr);
+    CHECK(result.complete);
+    CHECK(deleted == expectedDeleted);
+    CHECK(missing == expectedMissing);
+    // Far less than listing every id (about 24 bytes each)
+    CHECK(bytes < count * 24 / 10);
+
+    // Nothing local: every server id is missing
+    deleted.clear();
+    missing.clear();
+    result = pb.reconcile(nullptr, 0, difference, nullptr);
+    CHECK(result.complete && deleted.empty() && missing == server);
+
+    // A failing request leaves the result incomplete
+    host::handler = [](const HostRequest &) { return HostReply(500, "{}"); };
+    result = pb.reconcile(local.data(), local.size(), difference, nullptr);
+    CHECK(!result.complete);
+
+    return testsPassed("reconcile");
+}
+
+#else
+
+int main()
+{
+    return testsPassed("reconcile (disabled)");
+}
+
+#endif
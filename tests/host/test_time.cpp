@@ -0,0 +1,53 @@
+// Host test of the PocketBase timestamp helpers
+
+#include "PocketbaseTime.h"
+#include "host_test.h"
+
+static bool parses(const char *text, int64_t &epochMs)
+{
+    epochMs = -1;
+    return pocketbaseParseTimestamp(text, epochMs);
+}
+
+int main()
+{
+    int64_t ms;
+    CHECK(parses("1970-01-01 00:00:00.000Z", ms) && ms == 0);
+    CHECK(parses("2024-01-20 12:34:56.789Z", ms) && ms == 1705754096789LL);
+    CHECK(parses("2024-01-20T12:34:56Z", ms) && ms == 1705754096000LL);
+    CHECK(parses("2024-02-29 23:59:59.999Z", ms) && ms == 1709251199999LL);
+    CHECK(parses("1969-12-31 23:59:59.999Z", ms) && ms == -1);
+    CHECK(!parses("2024-13-01 00:00:00.000Z", ms));
+    // Days past the end of the month, February following the leap year rule
+    CHECK(!parses("2024-02-31 00:00:00.000Z", ms));
+    CHECK(!parses("2023-02-29 00:00:00.000Z", ms));
+    CHECK(!parses("1900-02-29 00:00:00.000Z", ms));
+    CHECK(parses("2000-02-29 00:00:00.000Z", ms) && ms == 951782400000LL);
+    CHECK(!parses("2024-04-31 00:00:00.000Z", ms));
+    CHECK(parses("2024-12-31 00:00:00.000Z", ms));
+    CHECK(pocketbaseDaysInMonth(2024, 2) == 29 && pocketbaseDaysInMonth(2100, 2) == 28 && pocketbaseDaysInMonth(2023, 11) == 30);
+    CHECK(!parses("2024-01-20", ms));
+    CHECK(!parses("", ms));
+
+    CHECK(pocketbaseParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT", ms) && ms == 784111777000LL);
+    CHECK(!pocketbaseParseHttpDate("Thu, 31 Apr 2025 08:49:37 GMT", ms));
+    CHECK(!pocketbaseParseHttpDate("Sun, 29 Feb 2023 08:49:37 GMT", ms));
+    CHECK(!pocketbaseParseHttpDate("Sun, 06 Nov 1994 24:49:37 GMT", ms));
+
+    char text[PB_TIMESTAMP_SIZE];
+    pocketbaseFormatTimestamp(1705754096789LL, text);
+    CHECK(strcmp(text, "2024-01-20 12:34:56.789Z") == 0);
+
+    // Every day of 1900..2400 survives the round trip through the civil calendar
+    int mismatches = 0;
+    for (int32_t days = pocketbaseDaysFromCivil(1900, 1, 1); days < pocketbaseDaysFromCivil(2400, 1, 1); days++)
+    {
+        int32_t year;
+        uint32_t month, day;
+        pocketbaseCivilFromDays(days, year, month, day);
+        mismatches += pocketbaseDaysFromCivil(year, month, day) != days;
+    }
+    CHECK(mismatches == 0);
+
+    return testsPassed("time");
+}
@@ -0,0 +1,86 @@
+// Host test of the request transport: bodies go through the raw client (headers and body start in one write),
+// GET through HTTPClient
+
+#include "PocketbaseExtended.h"
+#include "host_test.h"
+
+#if PB_ENABLE_COALESCED_WRITES
+
+int main()
+{
+    host::reset();
+    PocketbaseExtended pb("https://pb.example.com/pb");
+    pb.collection("readings");
+
+    // Chunked answer with the collected headers
+    host::serve("HTTP/1.1 200 OK\r\nDate: Sun, 06 Nov 1994 08:49:37 GMT\r\nTransfer-Encoding: chunked\r\n"
+                "etag: \"abc\"\r\n\r\n5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n", false);
+    PocketbaseResponse response = pb.create("{\"a\":1}");
+    CHECK(response.statusCode() == 200 && response.body() == "hello world");
+#if PB_ENABLE_RESPONSE_HEADERS
+    CHECK(strcmp(pb.lastHeaders().etag, "\"abc\"") == 0);
+    CHECK(strcmp(pb.lastHeaders().date, "Sun, 06 Nov 1994 08:49:37 GMT") == 0);
+#endif
+    CHECK(host::sent == "POST /pb/api/collections/readings/records/ HTTP/1.1\r\nHost: pb.example.com\r\n"
+                        "Content-Type: application/json\r\nContent-Length: 7\r\nConnection: close\r\n\r\n{\"a\":1}");
+    // Headers and body in a single write, so a single TLS record
+    CHECK(host::writes == 1 && host::records == 1);
+    CHECK(host::noDelay);
+
+    // A body larger than a TLS record, and extra bytes after Content-Length
+    host::serve("HTTP/1.1 400 Bad Request\r\nContent-Length: 4\r\n\r\nnopeXX", false);
+    std::string large(3000, 'x');
+    response = pb.create(String(large));
+    CHECK(response.statusCode() == 400 && response.body() == "nope");
+    CHECK(host::sent.size() > large.size() && host::sent.compare(host::sent.size() - large.size(), large.size(), large) == 0);
+    CHECK(host::writes == (host::sent.size() + PB_TLS_RECORD_SIZE - 1) / PB_TLS_RECORD_SIZE);
+    // Full slices are not split by the record overhead
+    CHECK(host::records == host::writes);
+
+    // Answered by the handler: GET through HTTPClient, PATCH through the raw client
+    host::handler = [](const HostRequest &request) {
+        host::now += 100;
+        return HostReply(200, "{\"method\":\"" + request.method + "\",\"body\":\"" + request.body + "\"}");
+    };
+    response = pb.getOne("abcdefghijklmno", nullptr, nullptr);
+    CHECK(response.body() == "{\"method\":\"GET\",\"body\":\"\"}");
+#if PB_ENABLE_UPDATE
+    response = pb.update("abcdefghijklmno", "x");
+    CHECK(response.body() == "{\"method\":\"PATCH\",\"body\":\"x\"}");
+#endif
+
+    // Over a 50 ms link whose server delays its ACKs: TCP and TLS handshakes, then a single round trip, as
+    // Nagle never holds the body back
+    host::handler = [](const HostRequest &) { return HostReply(200, "{}"); };
+    host::link.rttMs = 50;
+    host::link.delayedAckMs = 200;
+    unsigned long before = host::now;
+    response = pb.create("{\"a\":1}");
+    CHECK(response.statusCode() == 200 && host::now - before == 4 * 50);
+    host::link = HostLink();
+
+    // Connection lost before the end of the body
+    host::serve("HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\nshort");
+    response = pb.create("{}");
+    CHECK(response.statusCode() == HTTPC_ERROR_CONNECTION_LOST);
+
+    // Transport failures keep their own negative codes: no server listening, a URL without a scheme
+    host::handler = nullptr;
+    host::now += 100;
+    response = pb.getOne("abcdefghijklmno", nullptr, nullptr);
+    CHECK(response.statusCode() == HTTPC_ERROR_CONNECTION_FAILED && response.body() == "");
+    PocketbaseExtended noScheme("pb.example.com/pb");
+    response = noScheme.collection("readings").getOne("abcdefghijklmno", nullptr, nullptr);
+    CHECK(response.statusCode() == PB_ERROR_INVALID_URL && noScheme.lastStatusCode() == PB_ERROR_INVALID_URL);
+
+    return testsPassed("transport");
+}
+
+#else
+
+int main()
+{
+    return testsPassed("transport (disabled)");
+}
+
+#endif
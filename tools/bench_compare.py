@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Compares the host benchmarks against the checked-in baseline.
+
+Runs `make -C tests/host bench`, reads the build/bench_*.json every bench writes (see tests/host/bench.h) and
+compares each metric with tools/bench_baseline.json. A metric worse than the baseline by more than its threshold
+is a regression: the differences are printed as a table and the exit code is 1.
+
+Metrics of the simulated clock and link (requests per second, latencies, radio-on time, bytes on the link), the
+allocation counts and the heap sizes are deterministic, so their threshold is tight. Host CPU timings ("ns") vary
+by more than 50% between runs of a shared machine and are only compared with --time-threshold, on a quiet machine
+that recorded the baseline itself.
+
+Usage: tools/bench_compare.py [--update] [--no-run] [--threshold PERCENT] [--time-threshold PERCENT]
+"""
+
+import argparse
+import glob
+import json
+import os
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HOST = os.path.join(ROOT, "tests", "host")
+BASELINE = os.path.join(ROOT, "tools", "bench_baseline.json")
+
+# Metrics for which a higher value is better, every other one is a cost
+HIGHER_IS_BETTER = {"ops_per_s"}
+# Metrics compared with --time-threshold
+HOST_TIMINGS = {"ns"}
+# Smaller differences are ignored: benchRun() averages over its runs the one-off allocations of a loop
+ABSOLUTE_TOLERANCE = 0.01
+
+
+def run_benches():
+    subprocess.run(["make", "-C", HOST, "bench"], check=True, stdout=sys.stderr)
+
+
+def load_results():
+    results = {}
+    for path in sorted(glob.glob(os.path.join(HOST, "build", "bench_*.json"))):
+        with open(path) as f:
+            results.update(json.load(f))
+    return results
+
+
+def change(baseline, current, metric):
+    """Relative change in percent, positive when current is worse."""
+    if abs(current - baseline) < ABSOLUTE_TOLERANCE:
+        return 0.0
+    if baseline == 0:
+        worse = current < 0 if metric in HIGHER_IS_BETTER else current > 0
+        return float("inf") if worse else float("-inf")
+    percent = (current - baseline) * 100.0 / abs(baseline)
+    return -percent if metric in HIGHER_IS_BETTER else percent
+
+
+def compare(baseline, results, threshold, time_threshold):
+    rows = []
+    regressions = 0
+    for bench in sorted(set(baseline) | set(results)):
+        cases = sorted(set(baseline.get(bench, {})) | set(results.get(bench, {})))
+        for case in cases:
+            old = baseline.get(bench, {}).get(case)
+            new = results.get(bench, {}).get(case)
+            if old is None:
+                rows.append(("new", bench, case, "", "", "", "", "not in the baseline"))
+                continue
+            if new is None:
+                rows.append(("REGRESSION", bench, case, "", "", "", "", "missing from the results"))
+                regressions += 1
+                continue
+            for metric in sorted(set(old) | set(new)):
+                if metric not in old or metric not in new:
+                    continue
+                limit = time_threshold if metric in HOST_TIMINGS else threshold
+                if metric in HOST_TIMINGS and time_threshold <= 0:
+                    continue
+                worse = change(old[metric], new[metric], metric)
+                if worse > limit:
+                    status = "REGRESSION"
+                    regressions += 1
+                elif worse < -limit:
+                    status = "better"
+                else:
+                    continue
+                rows.append((status, bench, case, metric, "%.6g" % old[metric], "%.6g" % new[metric],
+                             "%+.1f%%" % worse if abs(worse) != float("inf") else "from 0", "limit %g%%" % limit))
+    return rows, regressions
+
+
+def print_rows(rows):
+    header = ("", "bench", "case", "metric", "baseline", "current", "worse by", "")
+    widths = [max(len(str(row[i])) for row in rows + [header]) for i in range(len(header))]
+    for row in [header] + rows:
+        print("  ".join(str(value).ljust(width) for value, width in zip(row, widths)).rstrip())
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compares the host benchmarks against the checked-in baseline.")
+    parser.add_argument("--update", action="store_true", help="write the results as the new baseline")
+    parser.add_argument("--no-run", action="store_true", help="compare the results already in tests/host/build")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="regression threshold of the deterministic metrics, in percent (default 5)")
+    parser.add_argument("--time-threshold", type=float, default=0.0,
+                        help="regression threshold of the host CPU timings, in percent (default 0, not compared)")
+    args = parser.parse_args()
+
+    if not args.no_run:
+        run_benches()
+    results = load_results()
+    if not results:
+        print("no results in tests/host/build, run `make -C tests/host bench`")
+        return 1
+
+    if args.update:
+        with open(BASELINE, "w") as f:
+            json.dump(results, f, indent=1, sort_keys=True)
+            f.write("\n")
+        print("baseline updated: %s" % os.path.relpath(BASELINE, ROOT))
+        return 0
+
+    if not os.path.exists(BASELINE):
+        print("no baseline, record one with --update")
+        return 1
+    with open(BASELINE) as f:
+        baseline = json.load(f)
+
+    rows, regressions = compare(baseline, results, args.threshold, args.time_threshold)
+    if rows:
+        print_rows(rows)
+    if regressions:
+        print("%d regression(s) against %s" % (regressions, os.path.relpath(BASELINE, ROOT)))
+        return 1
+    print("no regression against %s" % os.path.relpath(BASELINE, ROOT))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
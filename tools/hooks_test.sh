@@ -0,0 +1,112 @@
+#!/bin/sh
+# Runs the pb_hooks routes against a throwaway PocketBase server.
+#
+# Starts `pocketbase serve` on an empty data directory with this repository's pb_hooks, creates a
+# collection whose list rule limits each user to their own records and whose "secret" field is hidden,
+# then checks as a user that pbext_aggregate.pb.js and pbext_digest.pb.js only count the records the
+# user may list, and that filters on hidden fields or other collections are refused.
+#
+# Usage: tools/hooks_test.sh [pocketbase binary]     (default pocketbase from PATH, v0.23+)
+
+POCKETBASE="${1:-pocketbase}"
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+PORT=48090
+URL="http://127.0.0.1:$PORT"
+
+if ! command -v "$POCKETBASE" >/dev/null 2>&1; then
+    echo "pocketbase not found, skipping hooks test"
+    exit 0
+fi
+if ! command -v curl >/dev/null 2>&1; then
+    echo "curl not found, skipping hooks test"
+    exit 0
+fi
+
+WORK="$(mktemp -d)"
+PID=""
+trap 'kill $PID 2>/dev/null; rm -rf "$WORK"' EXIT
+
+"$POCKETBASE" superuser upsert admin@example.com password123 --dir="$WORK/pb_data" >/dev/null || exit 1
+"$POCKETBASE" serve --http="127.0.0.1:$PORT" --dir="$WORK/pb_data" --hooksDir="$ROOT/pb_hooks" \
+    >"$WORK/server.log" 2>&1 &
+PID=$!
+for i in 1 2 3 4 5 6 7 8 9 10; do
+    curl -sf "$URL/api/health" >/dev/null && break
+    sleep 1
+done
+
+FAILED=0
+
+# Checks that the output of a request contains the expected text
+check() {
+    label="$1"
+    output="$2"
+    expected="$3"
+    case "$output" in
+    *"$expected"*)
+        echo "$label: ok"
+        ;;
+    *)
+        echo "$label: FAILED, expected $expected in $output"
+        FAILED=1
+        ;;
+    esac
+}
+
+# POST of a JSON body with an optional token, prints the response
+post() {
+    curl -s -X POST -H "Content-Type: application/json" ${3:+-H "Authorization: $3"} -d "$2" "$URL$1"
+}
+
+token() {
+    echo "$1" | sed -n 's/.*"token":"\([^"]*\)".*/\1/p'
+}
+
+ADMIN=$(token "$(post /api/collections/_superusers/auth-with-password \
+    '{"identity":"admin@example.com","password":"password123"}')")
+[ -n "$ADMIN" ] || { echo "superuser login failed"; cat "$WORK/server.log"; exit 1; }
+
+post /api/collections '{"name":"readings","type":"base","listRule":"owner = @request.auth.id",
+    "fields":[{"name":"owner","type":"text"},{"name":"device","type":"text"},{"name":"temperature","type":"number"},
+    {"name":"at","type":"date"},{"name":"secret","type":"text","hidden":true}]}' "$ADMIN" >/dev/null
+
+USER_ID=$(post /api/collections/users/records \
+    '{"email":"user@example.com","password":"password123","passwordConfirm":"password123"}' "$ADMIN" |
+    sed -n 's/.*"id":"\([^"]*\)".*/\1/p')
+USER=$(token "$(post /api/collections/users/auth-with-password \
+    '{"identity":"user@example.com","password":"password123"}')")
+
+# Three records of the user on two days, one of another user and one of another device
+for record in \
+    "$USER_ID a 20 2024-01-20 x" "$USER_ID a 23 2024-01-20 y" "$USER_ID a 12 2024-01-21 x" \
+    "other a 99 2024-01-20 x" "$USER_ID b 50 2024-01-20 x"; do
+    set -- $record
+    post /api/collections/readings/records "{\"owner\":\"$1\",\"device\":\"$2\",\"temperature\":$3,
+        \"at\":\"$4 08:00:00.000Z\",\"secret\":\"$5\"}" "$ADMIN" >/dev/null
+done
+
+# GET of a hook route as the user, the remaining arguments are query parameters
+get() {
+    path="$1"
+    shift
+    for parameter in "$@"; do
+        set -- "$@" --data-urlencode "$parameter"
+        shift
+    done
+    curl -s -G -H "Authorization: $USER" "$@" "$URL$path"
+}
+
+check "aggregate" "$(get /api/pbext/aggregate/readings field=temperature bucket=day timeField=at "filter=device = 'a'")" \
+    '"items":[["2024-01-20",2,21.5,20,23],["2024-01-21",1,12,12,12]]'
+check "aggregate without filter" "$(get /api/pbext/aggregate/readings field=temperature bucket=month timeField=at)" \
+    '"items":[["2024-01",4,26.25,12,50]]'
+check "aggregate hidden field" "$(get /api/pbext/aggregate/readings field=secret timeField=at)" '"status":400'
+check "aggregate filter on hidden field" \
+    "$(get /api/pbext/aggregate/readings field=temperature timeField=at "filter=secret = 'y'")" '"status":400'
+check "aggregate filter on another collection" \
+    "$(get /api/pbext/aggregate/readings field=temperature timeField=at "filter=@collection.users.email ?= 'a'")" \
+    '"status":400'
+check "digest" "$(get /api/pbext/digest/readings ranges=1 "filter=device = 'a'")" '"items":[[3,'
+check "digest filter on hidden field" "$(get /api/pbext/digest/readings ranges=1 "filter=secret = 'y'")" '"status":400'
+
+exit $FAILED
@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""Generates typed record structs for PocketbaseExtended from a PocketBase collections export.
+
+Export the collections from the dashboard (Settings > Export collections) and run:
+
+    tools/pocketbase_codegen.py pb_schema.json -o PocketbaseSchema.h
+
+For each collection the header holds a record struct, its field table, the `fields=` projection
+listing exactly those fields, and decode/encode functions:
+
+    ReadingsRecord reading;
+    PocketbaseResponse response = pb.collection(READINGS_COLLECTION).getOne(id, nullptr, READINGS_FIELDS);
+    decodeReadings(response.c_str(), reading);
+
+Members are ordered by alignment, so the structs have no padding without being declared packed
+(unaligned members would need byte-wise loads on Xtensa). Multi-value and json fields are left out.
+Record ids and single relations are packed as PocketbaseRecordId (10 bytes) when the collection keeps
+the default [a-z0-9]{15} ids, and stored as text otherwise.
+Both the PocketBase >= 0.23 ("fields") and older ("schema") export formats are read.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+ID_SIZE = 16  # 15 characters record ids, when they cannot be packed
+
+# Field names that are not valid member names as they are, ex. a "class" or "default" field
+CPP_KEYWORDS = frozenset("""
+    alignas alignof and and_eq asm auto bitand bitor bool break case catch char char8_t char16_t char32_t
+    class compl concept const consteval constexpr constinit const_cast continue co_await co_return co_yield
+    decltype default delete do double dynamic_cast else enum explicit export extern false float for friend
+    goto if inline int long mutable namespace new noexcept not not_eq nullptr operator or or_eq private
+    protected public register reinterpret_cast requires return short signed sizeof static static_assert
+    static_cast struct switch template this thread_local throw true try typedef typeid typename union
+    unsigned using virtual void volatile wchar_t while xor xor_eq
+""".split())
+
+
+def identifier(name):
+    """Member name of a field. The JSON name is kept as is in the field table and the fields= projection."""
+    name = re.sub(r"[^0-9A-Za-z_]", "_", name)
+    if name in CPP_KEYWORDS:
+        return name + "_"
+    return "_" + name if name[:1].isdigit() else name
+
+
+def pascal_case(name):
+    return "".join(part[:1].upper() + part[1:] for part in re.split(r"[^0-9A-Za-z]+", name) if part)
+
+
+def camel_case(name):
+    pascal = pascal_case(name)
+    return pascal[:1].lower() + pascal[1:]
+
+
+def upper_snake(name):
+    return re.sub(r"[^0-9A-Za-z]+", "_", name).upper()
+
+
+def field_options(field):
+    # Older exports nest the field settings under "options"
+    options = dict(field.get("options") or {})
+    options.update({k: v for k, v in field.items() if k != "options"})
+    return options
+
+
+def collection_fields(collection):
+    if "fields" in collection:
+        return [field_options(f) for f in collection["fields"]]
+
+    # Older exports leave the system fields out
+    fields = [{"name": "id", "type": "text", "system": True, "min": 15, "max": 15, "pattern": "^[a-z0-9]+$"}]
+    fields += [field_options(f) for f in collection.get("schema", [])]
+    fields += [{"name": "created", "type": "autodate"}, {"name": "updated", "type": "autodate"}]
+    return fields
+
+
+def packed_ids(collection):
+    """Tells whether the ids of a collection are the default [a-z0-9]{15} ones PocketbaseRecordId can hold."""
+    for field in collection_fields(collection):
+        if field.get("name") == "id":
+            return (field.get("pattern") in ("^[a-z0-9]+$", "^[a-z0-9]{15}$")
+                    and field.get("min") == 15 and field.get("max") == 15)
+    return False
+
+
+def member(field, text_size, packed):
+    """Returns (C type, array size, field type, writable), or None when the field is not supported.
+    packed tells, from a collection id, whether its record ids can be packed."""
+    kind = field.get("type")
+    name = field.get("name")
+    max_select = field.get("maxSelect") or 1
+
+    if field.get("hidden") or kind == "password":
+        return None
+    if name == "id":
+        if packed(None):
+            return ("PocketbaseRecordId", None, "PB_FIELD_RECORD_ID", False)
+        return ("char", ID_SIZE, "PB_FIELD_TEXT", False)
+    if kind == "number":
+        if field.get("onlyInt") or field.get("noDecimal"):
+            return ("int32_t", None, "PB_FIELD_INT", True)
+        return ("float", None, "PB_FIELD_FLOAT", True)
+    if kind == "bool":
+        return ("bool", None, "PB_FIELD_BOOL", True)
+    if kind == "autodate":
+        return ("int64_t", None, "PB_FIELD_TIMESTAMP", False)
+    if kind == "date":
+        return ("int64_t", None, "PB_FIELD_TIMESTAMP", True)
+    if max_select > 1:
+        return None
+    if kind == "relation":
+        if packed(field.get("collectionId")):
+            return ("PocketbaseRecordId", None, "PB_FIELD_RECORD_ID", True)
+        return ("char", ID_SIZE, "PB_FIELD_TEXT", True)
+    if kind == "select":
+        values = field.get("values") or []
+        size = max([len(v.encode("utf-8")) for v in values] or [text_size - 1]) + 1
+        return ("char", size, "PB_FIELD_TEXT", True)
+    if kind in ("text", "email", "url", "editor", "file"):
+        size = text_size
+        if kind == "text" and field.get("max"):
+            size = min(int(field["max"]) * 4, 1024) + 1  # max counts characters, up to 4 bytes each in UTF-8
+        return ("char", size, "PB_FIELD_TEXT", True)
+    return None
+
+
+def alignment(entry):
+    c_type = entry[1][0]
+    return {"int64_t": 0, "int32_t": 1, "float": 1, "PocketbaseRecordId": 2, "bool": 3}.get(c_type, 4)
+
+
+def generate(collections, source, text_size):
+    out = []
+    out.append("// PocketbaseSchema.h")
+    out.append("//")
+    out.append("// Generated by tools/pocketbase_codegen.py from %s, do not edit." % source)
+    out.append("")
+    out.append("#ifndef PocketbaseSchema_h")
+    out.append("#define PocketbaseSchema_h")
+    out.append("")
+    out.append("#include <stddef.h>")
+    out.append("#include \"PocketbaseRecord.h\"")
+
+    by_id = {c.get("id"): packed_ids(c) for c in collections}
+
+    for collection in collections:
+        if collection.get("type") == "view":
+            continue
+        name = collection["name"]
+        own = packed_ids(collection)
+
+        def packed(collection_id):
+            if collection_id is None:
+                return own
+            # Relations to a collection missing from the export are assumed to use default ids
+            return by_id.get(collection_id, True)
+
+        struct = pascal_case(name) + "Record"
+        table = camel_case(name) + "Fields"
+        macro = upper_snake(name)
+
+        entries = []
+        skipped = []
+        for field in collection_fields(collection):
+            described = member(field, text_size, packed)
+            if described is None:
+                skipped.append("%s (%s)" % (field.get("name"), field.get("type")))
+            else:
+                entries.append((field["name"], described))
+        entries.sort(key=alignment)
+
+        out.append("")
+        out.append("// Collection \"%s\"" % name)
+        if skipped:
+            out.append("// Not generated: %s" % ", ".join(skipped))
+        out.append("struct %s" % struct)
+        out.append("{")
+        for field_name, (c_type, size, _, _) in entries:
+            suffix = "[%d]" % size if size else ""
+            out.append("    %s %s%s;" % (c_type, identifier(field_name), suffix))
+        out.append("};")
+        out.append("")
+        out.append("static const PocketbaseField %s[] = {" % table)
+        for field_name, (_, _, field_type, writable) in entries:
+            out.append("    {\"%s\", %s, %s, offsetof(%s, %s), sizeof(%s::%s)}," % (
+                field_name, field_type, "true" if writable else "false",
+                struct, identifier(field_name), struct, identifier(field_name)))
+        out.append("};")
+        out.append("")
+        out.append("#define %s_COLLECTION \"%s\"" % (macro, name))
+        out.append("// fields= projection returning only the members of %s" % struct)
+        out.append("#define %s_FIELDS \"%s\"" % (macro, ",".join(n for n, _ in entries)))
+        out.append("")
+        out.append("inline bool decode%s(const char *json, %s &record)" % (pascal_case(name), struct))
+        out.append("{")
+        out.append("    return pocketbaseDecodeRecord(json, %s, sizeof(%s) / sizeof(%s[0]), &record);" % (table, table, table))
+        out.append("}")
+        out.append("")
+        out.append("inline void encode%s(const %s &record, String &json)" % (pascal_case(name), struct))
+        out.append("{")
+        out.append("    pocketbaseEncodeRecord(&record, %s, sizeof(%s) / sizeof(%s[0]), json);" % (table, table, table))
+        out.append("}")
+
+    out.append("")
+    out.append("#endif")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("schema", help="collections export (JSON)")
+    parser.add_argument("-o", "--output", help="header to write (default to stdout)")
+    parser.add_argument("--text-size", type=int, default=64,
+                        help="bytes reserved for text fields without a max length (default to 64)")
+    args = parser.parse_args()
+
+    with open(args.schema, encoding="utf-8") as schema:
+        collections = json.load(schema)
+    if isinstance(collections, dict):
+        collections = collections.get("collections", [])
+
+    header = generate(collections, args.schema.split("/")[-1], args.text_size)
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as output:
+            output.write(header)
+    else:
+        sys.stdout.write(header)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,92 @@
+#!/bin/sh
+# Flash/RAM cost of every PocketbaseExtended feature flag (see PocketbaseConfig.h).
+#
+# Builds examples/pocketbaseextended_example_getOne.ino once with every feature off, once with the
+# defaults, and once per feature with only that feature on, then prints the sizes reported by
+# arduino-cli. Needs arduino-cli with the target core installed.
+#
+# With --host, the same builds are linked for the PC against the stand-ins of tests/host/stubs, at -Os
+# with unused sections dropped, and the sizes are those `size` reports for the executable (text +
+# data as flash, data + bss as ram). This is x86-64 code around the stubs, so only the differences
+# between rows carry over to the boards, not the absolute numbers. Needs a C++17 compiler.
+#
+# Usage: tools/size_matrix.sh [fqbn]     (default esp8266:esp8266:nodemcuv2)
+#        tools/size_matrix.sh --host
+
+FQBN="${1:-esp8266:esp8266:nodemcuv2}"
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+FEATURES="LOG STATS DIAGNOSTICS SERVER_CLOCK AUTH THROTTLE TIMEOUT_RETRY AGGREGATE RECONCILE OTA POLL
+          UPDATE COUNT RECORD_ID COALESCED_WRITES TLS_PROFILES RESPONSE_HEADERS"
+
+if [ "$1" = "--host" ]; then
+    CXX="${CXX:-g++}"
+    WORK="$(mktemp -d)"
+    trap 'rm -rf "$WORK"' EXIT
+    printf '#include "Arduino.h"\n#include "%s"\nint main()\n{\n    setup();\n    loop();\n    return 0;\n}\n' \
+        "$ROOT/examples/pocketbaseextended_example_getOne.ino" >"$WORK/sketch.cpp"
+
+    # Prints "<label> <flash bytes> <ram bytes>" for one build with the given -D flags
+    build() {
+        label="$1"
+        shift
+        rm -f "$WORK"/*.o
+        for source in "$ROOT"/*.cpp "$ROOT/tests/host/stubs/stubs.cpp" "$WORK/sketch.cpp"; do
+            "$CXX" -Os -std=gnu++17 -ffunction-sections -fdata-sections -isystem "$ROOT/tests/host/stubs" \
+                -I"$ROOT" "$@" -c "$source" -o "$WORK/$(basename "$source" .cpp).o" || return
+        done
+        "$CXX" -Wl,--gc-sections "$WORK"/*.o -o "$WORK/firmware" || return
+        size "$WORK/firmware" | awk -v label="$label" 'NR == 2 { printf "%-16s %10d %10d\n", label, $1 + $2, $2 + $3 }'
+    }
+else
+    if ! command -v arduino-cli >/dev/null 2>&1; then
+        echo "arduino-cli not found, skipping size matrix (tools/size_matrix.sh --host measures on the PC)"
+        exit 0
+    fi
+
+    if ! arduino-cli board details -b "$FQBN" >/dev/null 2>&1; then
+        echo "core for $FQBN not installed, skipping size matrix"
+        exit 0
+    fi
+
+    # arduino-cli wants the sketch in a directory of the same name
+    SKETCH="$(mktemp -d)/size_matrix"
+    mkdir -p "$SKETCH"
+    cp "$ROOT/examples/pocketbaseextended_example_getOne.ino" "$SKETCH/size_matrix.ino"
+    trap 'rm -rf "$(dirname "$SKETCH")"' EXIT
+
+    # Prints "<label> <flash bytes> <ram bytes>" for one build with the given -D flags
+    build() {
+        label="$1"
+        shift
+        output=$(arduino-cli compile -b "$FQBN" --library "$ROOT" \
+            --build-property "compiler.cpp.extra_flags=$*" "$SKETCH" 2>&1)
+        flash=$(echo "$output" | sed -n 's/.*Sketch uses \([0-9]*\) bytes.*/\1/p')
+        ram=$(echo "$output" | sed -n 's/.*Global variables use \([0-9]*\) bytes.*/\1/p')
+        printf "%-16s %10s %10s\n" "$label" "${flash:-error}" "${ram:-error}"
+    }
+fi
+
+# Flags disabling every feature but the ones given
+flags() {
+    result="-DPB_MAX_ENDPOINTS=1"
+    for feature in $FEATURES; do
+        value=0
+        for enabled in "$@"; do
+            [ "$feature" = "$enabled" ] && value=1
+        done
+        result="$result -DPB_ENABLE_$feature=$value"
+    done
+    echo "$result"
+}
+
+printf "%-16s %10s %10s\n" "build" "flash" "ram"
+build minimal $(flags)
+build default
+for feature in $FEATURES; do
+    # The timeout-retry computes its delay from the latency histogram
+    if [ "$feature" = TIMEOUT_RETRY ]; then
+        build "$feature" $(flags STATS TIMEOUT_RETRY)
+    else
+        build "$feature" $(flags "$feature")
+    fi
+done
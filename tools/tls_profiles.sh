@@ -0,0 +1,79 @@
+#!/bin/sh
+# Handshake cost of every PocketbaseTlsProfile (see PocketbaseExtended::setTlsProfile()).
+#
+# Times full TLS 1.2 handshakes (no session reuse) with openssl s_time, offering only the suites of
+# each profile, and prints the handshakes per second and the suite negotiated. Against a server, it
+# tells which profiles its certificate allows. Without argument, it starts local servers with an
+# ECDSA P-256 and an RSA 2048 certificate to compare the CPU cost of the key exchanges; the device
+# side ratio is measured with PocketbaseExtended::printTlsProfiles().
+#
+# Usage: tools/tls_profiles.sh [host:port] [seconds]     (default local servers, 5 s per profile)
+
+TARGET="$1"
+SECONDS_PER_PROFILE="${2:-5}"
+
+if ! command -v openssl >/dev/null 2>&1; then
+    echo "openssl not found, skipping TLS profiles"
+    exit 0
+fi
+
+# Profile name and OpenSSL names of its suites, in the order the library offers them. rsa-kex (static
+# RSA key exchange, offered by the default profile) is there for reference.
+PROFILES="
+default:ALL:!aNULL:!eNULL
+ecdsa-aead:ECDHE-ECDSA-CHACHA20-POLY1305:ECDHE-ECDSA-AES128-GCM-SHA256
+rsa-aead:ECDHE-RSA-CHACHA20-POLY1305:ECDHE-RSA-AES128-GCM-SHA256
+ecdhe-aead:ECDHE-ECDSA-CHACHA20-POLY1305:ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-CHACHA20-POLY1305:ECDHE-RSA-AES128-GCM-SHA256
+rsa-kex:AES128-GCM-SHA256"
+
+# Prints "<label> <profile> <handshakes/s> <suite>" for each profile against host:port
+measure() {
+    label="$1"
+    target="$2"
+    echo "$PROFILES" | while IFS= read -r line; do
+        [ -z "$line" ] && continue
+        profile="${line%%:*}"
+        suites="${line#*:}"
+        suite=$(openssl s_client -connect "$target" -tls1_2 -cipher "$suites" </dev/null 2>/dev/null |
+            sed -n 's/^ *Cipher *: *\(.*\)$/\1/p' | head -n 1)
+        if [ -z "$suite" ] || [ "$suite" = "0000" ]; then
+            printf "%-12s %-12s %14s %s\n" "$label" "$profile" "refused" "-"
+            continue
+        fi
+        rate=$(openssl s_time -connect "$target" -new -tls1_2 -cipher "$suites" -time "$SECONDS_PER_PROFILE" 2>/dev/null |
+            sed -n 's/.*connections in [0-9.]*s; \([0-9.]*\) connections\/user sec.*/\1/p' | head -n 1)
+        printf "%-12s %-12s %14s %s\n" "$label" "$profile" "${rate:-error}" "$suite"
+    done
+}
+
+printf "%-12s %-12s %14s %s\n" "server" "profile" "handshakes/s" "suite"
+
+if [ -n "$TARGET" ]; then
+    measure "$TARGET" "$TARGET"
+    exit 0
+fi
+
+WORK="$(mktemp -d)"
+PIDS=""
+trap 'kill $PIDS 2>/dev/null; rm -rf "$WORK"' EXIT
+
+# One local server per certificate type
+PORT=44330
+for key in ecdsa rsa; do
+    if [ "$key" = ecdsa ]; then
+        openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:P-256 -nodes -days 1 -subj /CN=localhost \
+            -keyout "$WORK/$key.key" -out "$WORK/$key.crt" >/dev/null 2>&1
+    else
+        openssl req -x509 -newkey rsa:2048 -nodes -days 1 -subj /CN=localhost \
+            -keyout "$WORK/$key.key" -out "$WORK/$key.crt" >/dev/null 2>&1
+    fi
+    openssl s_server -accept "$PORT" -cert "$WORK/$key.crt" -key "$WORK/$key.key" -cipher "ALL" -www -quiet \
+        >/dev/null 2>&1 &
+    PIDS="$PIDS $!"
+    eval "PORT_$key=$PORT"
+    PORT=$((PORT + 1))
+done
+sleep 1
+
+measure "local-ecdsa" "localhost:$PORT_ecdsa"
+measure "local-rsa" "localhost:$PORT_rsa"